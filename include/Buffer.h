@@ -1,10 +1,12 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 #include "stdafx.h"
+#include "MemoryAllocator.h"
 
 BEGIN_LPE
 
 class Commands;
+class StagingRing;
 
 class Buffer
 {
@@ -13,10 +15,12 @@ private:
   std::unique_ptr<vk::Device> device;
 
   vk::Buffer buffer;
-  vk::DeviceMemory memory;
+  MemoryAllocation memory;
   vk::DeviceSize size;
   vk::DescriptorBufferInfo descriptor;
-  void* mapped;
+
+  // host visible buffers stay mapped, see MemoryAllocator
+  uint8_t* GetMapped() const;
 
 protected:
   void CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties);
@@ -43,17 +47,25 @@ public:
 
   ~Buffer();
 
+  // destroys the vulkan buffer now instead of in the destructor
+  void Destroy();
+
   void CreateHostVisible(vk::DeviceSize size, void* data, vk::BufferUsageFlags usage);
   void CreateStaged(const Commands& commands, vk::DeviceSize size, void* data, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties);
 
   void Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer) const;
-  void CopyStaged(vk::CommandBuffer& commandBuffer, void* data);
+  void Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer, vk::DeviceSize srcOffset, vk::DeviceSize dstOffset, vk::DeviceSize size) const;
+  void Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer, const std::vector<vk::BufferCopy>& regions) const;
+  // recorded into the ring's command buffer, see StagingRing::Submit
+  void CopyStaged(StagingRing& stagingRing, void* data);
 
   void CopyToBufferMemory(void* data, size_t size);
   void CopyToBufferMemory(void* data);
+  // writes the source ranges of the regions, data has the same layout as the buffer
+  void CopyToBufferMemory(const void* data, const std::vector<vk::BufferCopy>& regions);
 
   vk::Buffer GetBuffer();
-  vk::DeviceMemory* GetMemory();
+  const MemoryAllocation& GetMemory() const;
   vk::DescriptorBufferInfo GetDescriptor();
   vk::DeviceSize GetSize();
 };
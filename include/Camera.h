@@ -45,6 +45,11 @@ public:
     return lookAt;
   }
 
+  vk::Extent2D GetExtent() const
+  {
+    return swapChainExtent;
+  }
+
 	void SetFoV(float fov)
 	{
 		this->fov = fov;
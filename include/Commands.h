@@ -4,6 +4,7 @@
 #include "Buffer.h"
 #include "ImageView.h"
 #include "Pipeline.h"
+#include "StagingRing.h"
 
 BEGIN_LPE
   class RenderPass;
@@ -17,6 +18,7 @@ private:
   std::unique_ptr<vk::Queue> graphicsQueue;
   vk::CommandPool commandPool;
   std::vector<vk::CommandBuffer> commandBuffers;
+  std::shared_ptr<StagingRing> stagingRing;
 
 public:
   Commands() = default;
@@ -25,7 +27,7 @@ public:
   Commands& operator=(const Commands& other);
   Commands& operator=(Commands&& other) noexcept;
 
-  Commands(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::Queue* graphicsQueue, uint32_t graphicsFamilyIndex);
+  Commands(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::Queue* graphicsQueue, uint32_t graphicsFamilyIndex, vk::DeviceSize stagingSize = StagingRing::DefaultSize);
 
   ~Commands();
 
@@ -35,6 +37,15 @@ public:
   vk::CommandBuffer BeginSingleTimeCommands() const;
   void EndSingleTimeCommands(vk::CommandBuffer commandBuffer) const;
 
+  // like EndSingleTimeCommands but doesn't wait, poll the fence with IsFinished and release both with FreeSingleTimeCommands
+  vk::Fence SubmitSingleTimeCommands(vk::CommandBuffer commandBuffer) const;
+  bool IsFinished(vk::Fence fence) const;
+  void WaitFor(vk::Fence fence) const;
+  void FreeSingleTimeCommands(vk::CommandBuffer commandBuffer, vk::Fence fence) const;
+
+  // every upload goes through it, see Buffer::CreateStaged and UniformBuffer::Update
+  StagingRing& GetStagingRing() const;
+
   lpe::Buffer CreateBuffer(void* data, vk::DeviceSize size) const;
   lpe::Buffer CreateBuffer(vk::DeviceSize size) const;
   lpe::ImageView CreateDepthImage(vk::Extent2D extent, vk::Format depthFormat) const;
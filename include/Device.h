@@ -42,7 +42,8 @@ public:
 
   SwapChain CreateSwapChain(uint32_t width, uint32_t height);
   Commands CreateCommands();
-  UniformBuffer CreateUniformBuffer(ModelsRenderer& modelsRenderer, const Camera& camera, const Commands& commands);
+  UniformBuffer CreateUniformBuffer(ModelsRenderer& modelsRenderer, const Camera& camera, const Commands& commands, InstanceEncoding instanceEncoding = InstanceEncoding::Matrix, InstanceBuilder* instanceBuilder = nullptr);
+  InstanceBuilder CreateInstanceBuilder(InstanceEncoding instanceEncoding);
   Pipeline CreatePipeline(const SwapChain& swapChain, RenderPass& renderPass, UniformBuffer* ubo);
   ModelsRenderer CreateModelsRenderer(Commands* commands);
   RenderPass CreateRenderPass(vk::Format swapChainImageFormat);
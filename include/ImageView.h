@@ -1,6 +1,7 @@
 #ifndef ImageView_H
 #define ImageView_H
 #include "stdafx.h"
+#include "MemoryAllocator.h"
 
 BEGIN_LPE
 
@@ -11,7 +12,7 @@ private:
 
   vk::Image image;
   vk::ImageView imageView;
-  vk::DeviceMemory memory;
+  MemoryAllocation memory;
 public:
   ImageView() = default;
   ImageView(const ImageView& other);
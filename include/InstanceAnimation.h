@@ -0,0 +1,45 @@
+#ifndef INSTANCEANIMATION_H
+#define INSTANCEANIMATION_H
+#include "stdafx.h"
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+BEGIN_LPE
+
+// ambient motion evaluated by the vertex shaders from UniformBufferObject::time, see shaders/instance.glsl
+enum class AnimationType : uint32_t
+{
+  None,
+  Spin,   // rotates around axis by speed * time + phase radians
+  Bob,    // moves along axis by amplitude * sin(speed * time + phase)
+  Sway    // rotates around axis by amplitude * sin(speed * time + phase) radians
+};
+
+// per instance, the axis is in world space and goes through the instance's position
+struct InstanceAnimation
+{
+  AnimationType type = AnimationType::None;
+  glm::vec3 axis = { 0, 0, 1 };
+  float speed = 0.0f;
+  float phase = 0.0f;
+  float amplitude = 0.0f;
+};
+
+// InstanceAnimation as the vertex shaders read it from binding 2, in the same order as the instances
+struct AnimationData
+{
+  glm::vec4 pivotType;       // xyz position of the instance, w type
+  glm::vec4 axisSpeed;       // xyz normalized axis, w speed
+  glm::vec4 phaseAmplitude;  // x phase, y amplitude
+};
+
+AnimationData EncodeAnimation(const InstanceAnimation& animation, glm::vec3 pivot);
+
+// binding 2, locations 7 to 9
+vk::VertexInputBindingDescription GetAnimationBindingDescription();
+std::vector<vk::VertexInputAttributeDescription> GetAnimationAttributeDescriptions();
+
+END_LPE
+
+#endif
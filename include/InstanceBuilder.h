@@ -0,0 +1,56 @@
+#ifndef INSTANCEBUILDER_H
+#define INSTANCEBUILDER_H
+#include "stdafx.h"
+#include "InstanceEncoding.h"
+
+BEGIN_LPE
+
+// expands encoded instances into InstanceData matrices with shaders/instances.comp
+// the parameters are uploaded in the compact encoding, the matrices never leave the device
+class InstanceBuilder
+{
+private:
+  vk::PhysicalDevice physicalDevice;
+  std::unique_ptr<vk::Device> device;
+
+  vk::PipelineCache cache;
+
+  InstanceEncoding encoding = InstanceEncoding::Matrix;
+
+  vk::DescriptorSetLayout descriptorSetLayout;
+  vk::PipelineLayout pipelineLayout;
+  vk::Pipeline pipeline;
+  vk::DescriptorPool descriptorPool;
+  vk::DescriptorSet descriptorSet;
+
+  void CreateDescriptorPool();
+  void CreateDescriptorSetLayout();
+  void CreatePipeline();
+
+  void Copy(const InstanceBuilder& other);
+  void Move(InstanceBuilder& other);
+
+public:
+  InstanceBuilder() = default;
+  InstanceBuilder(const InstanceBuilder& other);
+  InstanceBuilder(InstanceBuilder&& other) noexcept;
+  InstanceBuilder& operator=(const InstanceBuilder& other);
+  InstanceBuilder& operator=(InstanceBuilder&& other) noexcept;
+
+  InstanceBuilder(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::PipelineCache cache, InstanceEncoding encoding);
+
+  ~InstanceBuilder();
+
+  // parameters holds the encoded instances, matrices receives one InstanceData per instance
+  void UpdateDescriptorSets(vk::DescriptorBufferInfo parameters, vk::DescriptorBufferInfo matrices);
+
+  // waits for transfers into the parameters and makes the matrices visible to the vertex input
+  // only the matrices of the given ranges are built again, they have to be sorted and must not overlap
+  void Build(vk::CommandBuffer commandBuffer, const std::vector<InstanceRange>& ranges) const;
+
+  InstanceEncoding GetEncoding() const;
+};
+
+END_LPE
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef INSTANCECOMPOSE_H
+#define INSTANCECOMPOSE_H
+#include "stdafx.h"
+#include "InstanceEncoding.h"
+
+BEGIN_LPE
+
+// writes translate(positions[i]) * transforms[i] of every streamed instance (see InstanceFlags::IsStreamed) to instances
+// without flags every instance is written, returns the number of written instances
+// uses SSE when the compiler targets it, plain floats otherwise
+uint32_t ComposeInstances(const glm::vec3* positions, const glm::mat4* transforms, const uint32_t* flags, uint32_t count, InstanceData* instances);
+
+END_LPE
+
+#endif
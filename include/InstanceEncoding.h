@@ -0,0 +1,68 @@
+#ifndef INSTANCEENCODING_H
+#define INSTANCEENCODING_H
+#include "stdafx.h"
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+BEGIN_LPE
+
+// transform of one instance as it is used on the cpu, the rows are the columns of the matrix
+struct InstanceData
+{
+  glm::vec4 row1;
+  glm::vec4 row2;
+  glm::vec4 row3;
+  glm::vec4 row4;
+};
+
+// how InstanceData is stored in the instance buffer, decoded by shaders/instance.glsl
+enum class InstanceEncoding : uint32_t
+{
+  Matrix,                           // InstanceData, 64 byte
+  Affine,                           // AffineInstance, 48 byte
+  PositionRotationScale,            // PositionRotationScaleInstance, 32 byte
+  QuantizedPositionRotationScale,   // QuantizedInstance, 16 byte
+  Count
+};
+
+// the upper three rows of the matrix, the last one is always 0, 0, 0, 1
+struct AffineInstance
+{
+  glm::vec4 rows[3];
+};
+
+// only for rotations and uniform scales, shearing and non-uniform scales are lost
+struct PositionRotationScaleInstance
+{
+  glm::vec4 positionScale;   // xyz position, w uniform scale
+  glm::vec4 rotation;        // unit quaternion, w is the real part
+};
+
+// like PositionRotationScaleInstance, the position is a half float and only exact to about 1/1000 of its distance to the origin
+struct QuantizedInstance
+{
+  uint16_t positionScale[4];   // half floats
+  int16_t rotation[4];         // snorm
+};
+
+// consecutive instances, counted in instances rather than bytes
+struct InstanceRange
+{
+  uint32_t first;
+  uint32_t count;
+};
+
+uint32_t GetInstanceStride(InstanceEncoding encoding);
+
+void EncodeInstances(const std::vector<InstanceData>& instances, InstanceEncoding encoding, std::vector<uint8_t>& encoded);
+// encodes count instances into encoded, which holds count * GetInstanceStride(encoding) bytes
+void EncodeInstances(const InstanceData* instances, size_t count, InstanceEncoding encoding, uint8_t* encoded);
+
+// binding 1, every encoding provides locations 3 to 6 so the shaders only differ in their specialization constant
+vk::VertexInputBindingDescription GetInstanceBindingDescription(InstanceEncoding encoding);
+std::vector<vk::VertexInputAttributeDescription> GetInstanceAttributeDescriptions(InstanceEncoding encoding);
+
+END_LPE
+
+#endif
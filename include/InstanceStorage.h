@@ -0,0 +1,119 @@
+#ifndef INSTANCESTORAGE_H
+#define INSTANCESTORAGE_H
+#include "stdafx.h"
+#include "InstanceEncoding.h"
+#include "InstanceAnimation.h"
+#include <vector>
+
+BEGIN_LPE
+
+// stays valid while other instances are added or removed, a removed instance's handle never points to a new one
+struct InstanceHandle
+{
+  uint32_t slot = UINT32_MAX;
+  uint32_t generation = 0;
+};
+
+namespace InstanceFlags
+{
+  const uint32_t Visible = 1 << 0;
+  const uint32_t Static = 1 << 1;   // never changes after its object became resident, see ModelsRenderer
+  const uint32_t Baked = 1 << 2;    // merged into a static chunk, set by InstanceStorage::Bake
+
+  // visible instances which weren't baked are uploaded every frame
+  inline bool IsStreamed(uint32_t flags)
+  {
+    return (flags & (Visible | Baked)) == Visible;
+  }
+}
+
+// instances of one RenderObject as parallel arrays without gaps, so packing them is a linear pass
+// handles are resolved through a generational slot map, removing swaps the last instance into the hole
+class InstanceStorage
+{
+private:
+  struct Slot
+  {
+    uint32_t dense;
+    uint32_t generation;
+  };
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::mat4> transforms;
+  std::vector<uint32_t> flags;
+  std::vector<InstanceAnimation> animations;
+  std::vector<uint32_t> slotOfDense;
+
+  std::vector<Slot> slots;
+  std::vector<uint32_t> freeSlots;
+
+  uint32_t streamedCount = 0;
+  uint32_t version = 0;
+
+  uint32_t GetDense(InstanceHandle handle) const;
+  void CheckRange(uint32_t first, uint32_t count) const;
+
+public:
+  InstanceHandle Add();
+  // adds count instances with consecutive indices, their handles are appended to handles
+  void Add(uint32_t count, std::vector<InstanceHandle>& handles);
+  void Remove(InstanceHandle handle);
+  bool IsValid(InstanceHandle handle) const;
+  void Clear();
+
+  void SetPosition(InstanceHandle handle, glm::vec3 position);
+  void Move(InstanceHandle handle, glm::vec3 delta);
+  glm::vec3 GetPosition(InstanceHandle handle) const;
+
+  void SetTransform(InstanceHandle handle, glm::mat4 transform);
+  glm::mat4 Transform(InstanceHandle handle, glm::mat4 transform);
+  glm::mat4 GetTransform(InstanceHandle handle) const;
+
+  // evaluated on the gpu, changing it is the only upload an animated instance causes
+  void SetAnimation(InstanceHandle handle, const InstanceAnimation& animation);
+  InstanceAnimation GetAnimation(InstanceHandle handle) const;
+
+  void SetVisible(InstanceHandle handle, bool visible);
+  bool IsVisible(InstanceHandle handle) const;
+
+  // static instances are baked once their object becomes resident, changing a baked instance has no effect
+  // instances which are added or flagged later keep being streamed
+  void SetStatic(InstanceHandle handle, bool isStatic);
+  bool IsStatic(InstanceHandle handle) const;
+  bool IsBaked(InstanceHandle handle) const;
+
+  // bulk access by dense index, the index of an instance changes when another one is removed
+  // instances which were added back to back and never removed keep consecutive indices
+  uint32_t GetIndex(InstanceHandle handle) const;
+  InstanceHandle GetHandle(uint32_t index) const;
+
+  void SetPositions(uint32_t first, const glm::vec3* positions, uint32_t count);
+  void SetTransforms(uint32_t first, const glm::mat4* transforms, uint32_t count);
+  // positions and transforms hold one entry per handle
+  void SetPositions(const std::vector<InstanceHandle>& handles, const glm::vec3* positions);
+  void SetTransforms(const std::vector<InstanceHandle>& handles, const glm::mat4* transforms);
+
+  // direct writes into GetCount() consecutive entries, valid until the next Add, Remove or Clear
+  // mapping counts as a change, map again in every frame the entries are written instead of keeping the pointer
+  glm::vec3* MapPositions();
+  glm::mat4* MapTransforms();
+
+  // number of instances, including hidden and baked ones
+  uint32_t GetCount() const;
+  // number of instances Pack appends
+  uint32_t GetStreamedCount() const;
+
+  // increases whenever Pack could append something different, an unchanged version lets the renderer skip the instances
+  uint32_t GetVersion() const;
+
+  // appends translate(position) * transform and the animation of every streamed instance
+  void Pack(std::vector<InstanceData>& instances, std::vector<AnimationData>& animations) const;
+
+  // appends translate(position) * transform of every visible static instance which wasn't baked yet
+  // the instances are marked as baked and leave the instance stream
+  void Bake(std::vector<InstanceData>& instances);
+};
+
+END_LPE
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include "stdafx.h"
+#include <string>
+
+BEGIN_LPE
+
+// read-only view of a whole file, mapped into memory instead of copied through a stream
+class MappedFile
+{
+private:
+  const char* data = nullptr;
+  size_t size = 0;
+
+  void Close();
+
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(const MappedFile& other) = delete;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  explicit MappedFile(const std::string& fileName);
+
+  ~MappedFile();
+
+  const char* GetData() const;
+  size_t GetSize() const;
+  bool Empty() const;
+};
+
+END_LPE
+
+#endif
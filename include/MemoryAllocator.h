@@ -0,0 +1,112 @@
+#ifndef MEMORYALLOCATOR_H
+#define MEMORYALLOCATOR_H
+#include "stdafx.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+BEGIN_LPE
+
+// a range of one of the allocator's blocks, or a vk::DeviceMemory of its own for large resources
+struct MemoryAllocation
+{
+  vk::DeviceMemory memory;
+  vk::DeviceSize offset = 0;
+  vk::DeviceSize size = 0;
+  uint32_t memoryType = 0;
+  bool dedicated = false;
+  void* mapped = nullptr;   // points to offset, host visible memory stays mapped for its whole lifetime
+};
+
+struct MemoryStats
+{
+  uint32_t blockCount = 0;
+  uint32_t dedicatedCount = 0;
+  uint32_t allocationCount = 0;   // including dedicated ones
+
+  vk::DeviceSize reservedSize = 0;    // allocated from the device
+  vk::DeviceSize requestedSize = 0;   // asked for by the resources
+  vk::DeviceSize usedSize = 0;        // requestedSize rounded up to the buddy sizes, the difference is lost to alignment
+
+  vk::DeviceSize freeSize = 0;        // unused parts of the blocks
+  vk::DeviceSize largestFreeRange = 0;
+  uint32_t freeRangeCount = 0;
+
+  // 0 if the free memory is one range, close to 1 if it's scattered into many small ones
+  float fragmentation = 0.0f;
+};
+
+// carves buffers and images out of a few large vk::DeviceMemory blocks per memory type with a buddy allocator
+// so the number of allocations stays far below maxMemoryAllocationCount
+// buffers and optimally tiled images get separate blocks if the device has a bufferImageGranularity
+class MemoryAllocator
+{
+private:
+  struct Block
+  {
+    vk::DeviceMemory memory;
+    vk::DeviceSize size;
+    uint32_t memoryType;
+    bool linear;
+    void* mapped;
+
+    // free ranges by order, a range of order n is MinSize << n bytes and aligned to its size
+    std::vector<std::set<vk::DeviceSize>> freeRanges;
+    // offset to order and requested size
+    std::map<vk::DeviceSize, std::pair<uint32_t, vk::DeviceSize>> allocations;
+  };
+
+  std::mutex mutex;
+  vk::PhysicalDevice physicalDevice;
+  vk::Device device;
+  vk::PhysicalDeviceMemoryProperties memoryProperties;
+  vk::DeviceSize bufferImageGranularity = 1;
+
+  std::vector<std::unique_ptr<Block>> blocks;
+  std::vector<MemoryAllocation> dedicatedAllocations;
+
+  void Bind(vk::PhysicalDevice physicalDevice, vk::Device device);
+  vk::DeviceSize GetBlockSize(uint32_t memoryType) const;
+  vk::DeviceMemory AllocateMemory(vk::DeviceSize size, uint32_t memoryType, void** mapped);
+  Block* CreateBlock(vk::DeviceSize size, uint32_t memoryType, bool linear);
+
+  static bool Allocate(Block& block, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+  static void Free(Block& block, vk::DeviceSize offset);
+
+public:
+  // smallest range handed out, every allocation is rounded up to a power of two of at least this size
+  static const vk::DeviceSize MinSize = 256;
+  static const vk::DeviceSize DefaultBlockSize = 64 * 1024 * 1024;
+
+  MemoryAllocator() = default;
+  MemoryAllocator(const MemoryAllocator& other) = delete;
+  MemoryAllocator(MemoryAllocator&& other) = delete;
+  MemoryAllocator& operator=(const MemoryAllocator& other) = delete;
+  MemoryAllocator& operator=(MemoryAllocator&& other) = delete;
+
+  ~MemoryAllocator() = default;
+
+  // linear is false for optimally tiled images
+  // resources larger than half a block, or with dedicated set, get a vk::DeviceMemory of their own
+  MemoryAllocation Allocate(vk::PhysicalDevice physicalDevice,
+                            vk::Device device,
+                            const vk::MemoryRequirements& requirements,
+                            vk::MemoryPropertyFlags properties,
+                            bool linear = true,
+                            bool dedicated = false);
+  // freeing an allocation twice does nothing
+  void Free(const MemoryAllocation& allocation);
+
+  MemoryStats GetStats();
+
+  // frees every block, has to be called before the device is destroyed
+  void Release(vk::Device device);
+
+  static MemoryAllocator& Shared();
+};
+
+END_LPE
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef MESH_H
+#define MESH_H
+#include "stdafx.h"
+#include "Vertex.h"
+#include <string>
+#include <vector>
+
+BEGIN_LPE
+
+enum class IndexFormat : uint32_t
+{
+  Uint16,
+  Uint32,
+  Count
+};
+
+const uint32_t IndexFormatCount = static_cast<uint32_t>(IndexFormat::Count);
+
+uint32_t GetIndexStride(IndexFormat format);
+
+// processing which is applied after parsing the source file
+// meshes loaded with different options are cached and shared separately
+struct MeshOptions
+{
+  bool weld = true;           // collapses duplicated vertices, see VertexWelder
+  float weldEpsilon = 0.0f;   // 0 only welds bit identical vertices
+
+  // see MeshOptimizer
+  bool optimizeVertexCache = true;
+  bool optimizeOverdraw = false;
+  bool optimizeVertexFetch = true;
+
+  // levels of detail including the full mesh, each one targets lodReduction times the triangles of the previous one
+  // see MeshSimplifier, fewer levels are generated if the mesh can't be simplified further
+  uint32_t lodCount = 4;
+  float lodReduction = 0.5f;
+
+  bool buildMeshlets = true;   // see MeshletBuilder
+
+  // VertexFormat::Flat and VertexFormat::Palette drop the normals before welding,
+  // so faces which only differed by their normal share vertices
+  VertexFormat vertexFormat = VertexFormat::Float;
+
+  uint64_t GetKey() const;
+};
+
+struct MeshStats
+{
+  uint32_t sourceVertexCount;   // before welding
+  uint32_t sourceIndexCount;
+
+  // simulated vertex cache efficiency before and after optimizing, see MeshOptimizer::AnalyzeVertexCache
+  float sourceAcmr;
+  float sourceAtvr;
+  float acmr;
+  float atvr;
+};
+
+// a range of Mesh::indices, drawn with the same vertices as the full mesh
+struct MeshLod
+{
+  uint32_t indexOffset;
+  uint32_t indexCount;
+  float error;   // how far the surface deviates from the full mesh at most, in mesh units
+};
+
+// a cluster of up to MeshletBuilder::MaxVertices vertices and MeshletBuilder::MaxTriangles triangles of the full mesh
+struct Meshlet
+{
+  uint32_t vertexOffset;     // into Mesh::meshletVertices
+  uint32_t triangleOffset;   // into Mesh::meshletTriangles, 3 local vertex indices per triangle
+  uint32_t vertexCount;
+  uint32_t triangleCount;
+
+  // bounding sphere
+  glm::vec3 center;
+  float radius;
+
+  // every triangle normal lies within the cone around coneAxis
+  // coneCutoff is the sine of the cone's half angle, 1 if the cluster can't be backface culled
+  glm::vec3 coneAxis;
+  float coneCutoff;
+
+  // true if no triangle of the cluster can face a camera at eye (in mesh space)
+  bool IsBackfacing(glm::vec3 eye) const;
+};
+
+// geometry of one asset, shared by every RenderObject created from the same file (see MeshRegistry)
+struct Mesh
+{
+  std::string path;
+  MeshOptions options;
+  MeshStats stats;
+
+  // only the array of the mesh's format is filled once loading finished
+  VertexFormat format = VertexFormat::Float;
+  std::vector<Vertex> vertices;
+  std::vector<PackedVertex> packedVertices;
+  std::vector<FlatVertex> flatVertices;
+  std::vector<PaletteVertex> paletteVertices;
+  std::vector<glm::vec3> palette;   // colors of paletteVertices, see Palette
+
+  std::vector<uint32_t> indices;   // all levels of detail back to back
+  std::vector<MeshLod> lods;       // lods[0] is the full mesh
+
+  std::vector<Meshlet> meshlets;
+  std::vector<uint32_t> meshletVertices;
+  std::vector<uint8_t> meshletTriangles;
+
+  // bounding sphere of the vertices, also the quantization range of packed vertices
+  glm::vec3 center;
+  float radius;
+
+  void ComputeBounds();
+
+  // converts the vertices to one of the quantized formats, the bounds have to be computed already
+  // meshes with more than Palette::MaxColors colors become VertexFormat::Flat instead of Palette, format holds the result
+  void Pack(VertexFormat format);
+
+  uint32_t GetVertexCount() const;
+  const void* GetVertexData() const;
+
+  // the vertices of any format as Vertex, quantized ones lose the precision they were packed with
+  std::vector<Vertex> Unpack() const;
+
+  // indices are kept as 32 bit, the renderer narrows them for meshes with few enough vertices
+  IndexFormat GetIndexFormat() const;
+};
+
+END_LPE
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+#include "stdafx.h"
+#include "Mesh.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+
+BEGIN_LPE
+
+// header of a cooked mesh (.lpem)
+// the vertex, index, lod and meshlet blocks which follow are stored exactly like they are uploaded to the gpu
+// vertices are stored in the mesh's VertexFormat
+// the format is native endian and only meant as a local cache next to the source file
+struct MeshCacheHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t vertexFormat;
+  uint32_t vertexStride;
+  uint32_t indexStride;
+  uint32_t meshletCount;
+
+  uint64_t sourceSize;
+  int64_t sourceTime;
+  uint64_t optionsKey;   // MeshOptions::GetKey the mesh was cooked with
+
+  MeshStats stats;
+
+  glm::vec3 center;
+  float radius;
+
+  uint64_t vertexCount;
+  uint64_t indexCount;
+  uint64_t vertexOffset;
+  uint64_t indexOffset;
+  uint64_t lodCount;
+  uint64_t lodOffset;
+  uint64_t meshletOffset;
+  uint64_t meshletVertexCount;
+  uint64_t meshletVertexOffset;
+  uint64_t meshletTriangleSize;   // in bytes
+  uint64_t meshletTriangleOffset;
+  uint64_t paletteCount;
+  uint64_t paletteOffset;
+};
+
+class MeshCache
+{
+private:
+  MappedFile file;
+  const MeshCacheHeader* header = nullptr;
+
+public:
+  static const uint32_t Version = 7;
+
+  MeshCache() = default;
+  MeshCache(const MeshCache& other) = delete;
+  MeshCache(MeshCache&& other) noexcept;
+  MeshCache& operator=(const MeshCache& other) = delete;
+  MeshCache& operator=(MeshCache&& other) noexcept;
+
+  ~MeshCache() = default;
+
+  // maps the cache if it exists, is intact and was cooked from the current version of the source file with the same options
+  bool Open(const std::string& cachePath, const std::string& sourcePath, const MeshOptions& options);
+
+  VertexFormat GetVertexFormat() const;
+  const void* GetVertexData() const;
+  uint32_t GetVertexCount() const;
+  const uint32_t* GetIndices() const;
+  uint32_t GetIndexCount() const;
+  const MeshLod* GetLods() const;
+  uint32_t GetLodCount() const;
+  const Meshlet* GetMeshlets() const;
+  uint32_t GetMeshletCount() const;
+  const uint32_t* GetMeshletVertices() const;
+  uint32_t GetMeshletVertexCount() const;
+  const uint8_t* GetMeshletTriangles() const;
+  uint32_t GetMeshletTriangleSize() const;
+  const glm::vec3* GetPalette() const;
+  uint32_t GetPaletteCount() const;
+  MeshStats GetStats() const;
+  void GetBounds(glm::vec3& center, float& radius) const;
+
+  // <source name>.<options key>.lpem next to the source file
+  static std::string GetCachePath(const std::string& sourcePath, const MeshOptions& options);
+  static bool Write(const std::string& cachePath, const std::string& sourcePath, const Mesh& mesh);
+};
+
+END_LPE
+
+#endif
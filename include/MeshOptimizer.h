@@ -0,0 +1,38 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+#include "stdafx.h"
+#include "Vertex.h"
+#include <vector>
+
+BEGIN_LPE
+
+struct VertexCacheStats
+{
+  float acmr;   // transformed vertices per triangle, 0.5 is the best possible for regular grids, 3 the worst
+  float atvr;   // transformed vertices per referenced vertex, 1 is the best possible
+};
+
+// reorders triangles and vertices of indexed triangle lists for the gpu, the rendered result stays the same
+// runs in the order OptimizeVertexCache, OptimizeOverdraw, OptimizeVertexFetch
+class MeshOptimizer
+{
+public:
+  // size of the fifo cache which is simulated by AnalyzeVertexCache and OptimizeOverdraw
+  static const uint32_t SimulatedCacheSize = 16;
+
+  // Forsyth's linear speed vertex cache optimization
+  static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+  // splits the triangles where the vertex cache is cold anyway and draws outward facing clusters first
+  // keeps the cache efficiency of OptimizeVertexCache, so it should run after it
+  static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+
+  // orders the vertices by their first use and drops unreferenced ones, returns the new vertex count
+  static uint32_t OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+  static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount);
+};
+
+END_LPE
+
+#endif
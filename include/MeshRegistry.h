@@ -0,0 +1,55 @@
+#ifndef MESHREGISTRY_H
+#define MESHREGISTRY_H
+#include "stdafx.h"
+#include "Mesh.h"
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+BEGIN_LPE
+
+using MeshFuture = std::shared_future<std::shared_ptr<const Mesh>>;
+
+// hands out shared meshes keyed by their path and options, so each file is only parsed and kept in memory once
+// the registry only holds weak references, a mesh is freed together with its last user
+class MeshRegistry
+{
+private:
+  struct Entry
+  {
+    std::weak_ptr<const Mesh> mesh;
+    MeshFuture pending;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<std::string, Entry> meshes;
+
+  static void GenerateLods(Mesh& mesh, const MeshOptions& options);
+
+public:
+  MeshRegistry() = default;
+  MeshRegistry(const MeshRegistry& other) = delete;
+  MeshRegistry(MeshRegistry&& other) = delete;
+  MeshRegistry& operator=(const MeshRegistry& other) = delete;
+  MeshRegistry& operator=(MeshRegistry&& other) = delete;
+
+  ~MeshRegistry();
+
+  std::shared_ptr<const Mesh> Get(const std::string& path, const MeshOptions& options = {});
+
+  // parses the mesh on ThreadPool::Shared() and returns immediately
+  // requests for a file which is already loading share the same future
+  MeshFuture GetAsync(const std::string& path, const MeshOptions& options = {});
+
+  uint32_t GetCount();
+
+  // reads the mesh from its cooked cache or the source file, bypassing the registry
+  static std::shared_ptr<Mesh> Load(const std::string& path, const MeshOptions& options = {});
+
+  static MeshRegistry& Shared();
+};
+
+END_LPE
+
+#endif
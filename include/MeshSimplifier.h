@@ -0,0 +1,25 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+#include "stdafx.h"
+#include "Vertex.h"
+#include <vector>
+
+BEGIN_LPE
+
+// reduces the triangle count of indexed triangle lists by quadric error edge collapses (Garland and Heckbert)
+// collapses move one vertex onto a neighbour, so the result only references the original vertices
+// vertices with equal position and color are collapsed together, positions shared by several colors stay in place
+class MeshSimplifier
+{
+public:
+  // returns at most targetIndexCount indices if the mesh can be simplified that far
+  // error receives the largest distance a collapse moved the surface, in mesh units
+  static std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices,
+                                        const std::vector<uint32_t>& indices,
+                                        uint32_t targetIndexCount,
+                                        float& error);
+};
+
+END_LPE
+
+#endif
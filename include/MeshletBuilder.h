@@ -0,0 +1,21 @@
+#ifndef MESHLETBUILDER_H
+#define MESHLETBUILDER_H
+#include "stdafx.h"
+#include "Mesh.h"
+
+BEGIN_LPE
+
+// splits the full mesh (Mesh::lods[0]) into meshlets
+// triangles are taken in index order, so the clusters are as local as the vertex cache optimization made them
+class MeshletBuilder
+{
+public:
+  static const uint32_t MaxVertices = 64;
+  static const uint32_t MaxTriangles = 124;
+
+  static void Build(Mesh& mesh);
+};
+
+END_LPE
+
+#endif
@@ -3,17 +3,10 @@
 #include <string>
 #include "stdafx.h"
 #include "Vertex.h"
+#include "InstanceEncoding.h"
 
 BEGIN_LPE
 
-struct InstanceData
-{
-  glm::vec4 row1;
-  glm::vec4 row2;
-  glm::vec4 row3;
-  glm::vec4 row4;
-};
-
 class Model
 {
 private:
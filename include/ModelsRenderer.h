@@ -7,11 +7,56 @@
 #include <set>
 #include "Commands.h"
 #include "RenderObject.h"
+#include "Camera.h"
+#include <unordered_map>
+#include <array>
 
 BEGIN_LPE
 
 using ObjectRef = RenderObject*;
 
+// where a mesh ended up in the shared vertex and index buffers
+// holds a reference, so the mesh can't be freed (and its address reused) while its range is still uploaded
+struct MeshRange
+{
+  std::shared_ptr<const Mesh> mesh;
+  uint32_t indexOffset;
+  int32_t vertexOffset;
+  VertexFormat format;   // of the stream the vertices are in, Flat for palette meshes whose colors didn't fit
+};
+
+// consecutive draw commands which use the same vertex and index buffers
+struct DrawGroup
+{
+  uint32_t firstCommand;
+  uint32_t commandCount;
+};
+
+// what UpdateInstanceData wrote for an object, reused as long as its instances and their levels of detail stay the same
+struct ObjectInstances
+{
+  ObjectRef object = nullptr;
+  uint32_t version = 0;   // of its InstanceStorage
+  uint32_t first = 0;
+  uint32_t count = 0;
+  std::vector<uint32_t> lodCounts;
+};
+
+// buffers for objects which finished loading, filled on the gpu while the current buffers are still used for drawing
+struct GeometryUpload
+{
+  std::vector<ObjectRef> objects;
+
+  std::array<Buffer, VertexFormatCount> vertexBuffers;
+  std::array<Buffer, IndexFormatCount> indexBuffers;
+
+  std::array<Buffer, VertexFormatCount> vertexStaging;
+  std::array<Buffer, IndexFormatCount> indexStaging;
+
+  vk::CommandBuffer commandBuffer;
+  vk::Fence fence;
+};
+
 class ModelsRenderer
 {
 private:
@@ -21,17 +66,55 @@ private:
 	std::unique_ptr<vk::Device> device;
 	std::unique_ptr<Commands> commands;
 	std::vector<ObjectRef> objects;
+	std::vector<ObjectRef> queuedObjects;
+	std::unique_ptr<GeometryUpload> upload;
+
+	// one vertex stream per vertex format and one index stream per index format
+	// objects are kept sorted by both, so each combination is drawn with a single pipeline and index buffer
+	std::array<std::vector<uint8_t>, VertexFormatCount> vertices;
+	std::array<std::vector<uint8_t>, IndexFormatCount> indices;
+	std::unordered_map<const Mesh*, MeshRange> meshRanges;
+
+	// static instances of resident objects, merged into a few objects with a single instance each
+	std::vector<std::shared_ptr<RenderObject>> staticChunks;
+	float chunkSize = 32.0f;
 
-	std::vector<lpe::Vertex> vertices;
-	std::vector<uint32_t> indices;
+	std::array<Buffer, VertexFormatCount> vertexBuffers;
+	std::array<Buffer, IndexFormatCount> indexBuffers;
 
-	Buffer vertexBuffer;
-	Buffer indexBuffer;
+	// one command per object and level of detail, host visible because the instance counts change every frame
 	Buffer indirectBuffer;
+	std::vector<vk::DrawIndexedIndirectCommand> drawCommands;
+	std::array<std::array<DrawGroup, IndexFormatCount>, VertexFormatCount> drawGroups = {};
+	std::vector<std::vector<InstanceData>> lodInstances;
+	std::vector<std::vector<AnimationData>> lodAnimations;
+	float lodThreshold = 1.0f;
+
+	// the instances of all objects in draw order, only objects which changed are packed again (see UpdateInstanceData)
+	std::vector<InstanceData> instanceData;
+	std::vector<AnimationData> animationData;
+	std::vector<ObjectInstances> objectInstances;
+
+	// the levels of detail were picked for this view, moving the camera picks them again
+	glm::vec3 lodEye = glm::vec3(0.0f);
+	float lodPixelsPerUnit = 0.0f;
+	float lodSelectedThreshold = 0.0f;
 
 	void Copy(const ModelsRenderer& other);
 	void Move(ModelsRenderer& other);
 
+	void UpdateIndirectBuffer();
+
+	VertexFormat GetVertexFormat(ObjectRef obj) const;
+	bool AssignRange(ObjectRef obj);
+	std::vector<ObjectRef> BakeStatic(const std::vector<ObjectRef>& ready);
+	void SortObjects();
+	void BeginUpload(std::vector<ObjectRef> ready);
+	void FinishUpload();
+	void WaitForUpload();
+
+	static std::vector<vk::DrawIndexedIndirectCommand> GetDrawIndexedIndirectCommands(const std::vector<ObjectRef>& objects);
+
 public:
 	ModelsRenderer() = default;
 	ModelsRenderer(const ModelsRenderer& other);
@@ -43,15 +126,27 @@ public:
 
 	~ModelsRenderer();
 
+  // static instances (see InstanceStorage::SetStatic) are baked together with the object's geometry
   void AddObject(ObjectRef obj);
 
+  // doesn't block, the object is drawn once its mesh is loaded and uploaded (see ProcessQueue)
+  void QueueObject(ObjectRef obj);
+
+  // starts the upload for queued objects which finished loading and swaps in the buffers of a finished upload
+  // returns true if objects were added, in that case the command buffers have to be recorded again
+  bool ProcessQueue();
+  bool IsStreaming() const;
+
 	void UpdateBuffer();
 
+	// number of draw commands, one per object and level of detail
 	uint32_t GetCount() const;
-	std::vector<lpe::Vertex> GetVertices() const;
-	std::vector<uint32_t> GetIndices() const;
-	vk::Buffer GetVertexBuffer();
-	vk::Buffer GetIndexBuffer();
+
+	// the draw commands of objects with the same vertex and index format follow each other
+	DrawGroup GetDrawGroup(VertexFormat vertexFormat, IndexFormat indexFormat) const;
+
+	vk::Buffer GetVertexBuffer(VertexFormat format);
+	vk::Buffer GetIndexBuffer(IndexFormat format);
 
 	vk::Buffer GetIndirectBuffer();
 
@@ -60,7 +155,20 @@ public:
 
 	std::vector<vk::DrawIndexedIndirectCommand> GetDrawIndexedIndirectCommands();
 
-  std::vector<InstanceData> GetInstanceData() const;
+  // picks the level of detail of every instance and writes the draw commands for this frame
+  // the instance data is grouped by object and level of detail in the order of the draw commands
+  // objects whose instances didn't change are skipped, unless the camera moved and they have several levels of detail
+  // changed receives the instances which were written again, everything else kept its value
+  void UpdateInstanceData(const Camera& camera, std::vector<InstanceRange>& changed);
+  const std::vector<InstanceData>& GetInstanceData() const;
+  // the animation of each instance in the same order
+  const std::vector<AnimationData>& GetAnimationData() const;
+
+  // a coarser level of detail is drawn once its error covers less than this many pixels on screen
+  void SetLodThreshold(float pixels);
+
+  // edge length of the grid cells static instances are merged by, applies to objects which become resident later
+  void SetChunkSize(float size);
 };
 
 END_LPE
@@ -0,0 +1,51 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+#include "stdafx.h"
+#include <glm/glm.hpp>
+#include <mutex>
+#include <vector>
+
+BEGIN_LPE
+
+// colors of every mesh in VertexFormat::Palette, their vertices only hold an index into it (see shaders/palette.vert)
+// changing a color recolors every mesh which uses it without uploading any geometry
+class Palette
+{
+private:
+  std::mutex mutex;
+  std::vector<glm::vec4> colors;
+  uint32_t version = 0;
+
+public:
+  // the palette is a uniform buffer of this many vec4
+  static const uint32_t MaxColors = 256;
+
+  Palette() = default;
+  Palette(const Palette& other) = delete;
+  Palette(Palette&& other) = delete;
+  Palette& operator=(const Palette& other) = delete;
+  Palette& operator=(Palette&& other) = delete;
+
+  ~Palette() = default;
+
+  // returns the index of the color and adds it if it isn't part of the palette yet
+  uint32_t Add(glm::vec3 color);
+  // adds all colors or none of them, returns false if they don't fit, indices receives the index of each color
+  bool Add(const std::vector<glm::vec3>& colors, std::vector<uint32_t>& indices);
+  bool Find(glm::vec3 color, uint32_t& index);
+
+  void SetColor(uint32_t index, glm::vec3 color);
+
+  // changes every entry with the color from, returns false if there is none
+  bool Replace(glm::vec3 from, glm::vec3 to);
+
+  // increases whenever a color is added or changed
+  uint32_t GetVersion();
+  std::vector<glm::vec4> GetColors(uint32_t& version);
+
+  static Palette& Shared();
+};
+
+END_LPE
+
+#endif
@@ -2,6 +2,8 @@
 #define PIPELINE_H
 #include "stdafx.h"
 #include "UniformBuffer.h"
+#include "Vertex.h"
+#include <array>
 
 BEGIN_LPE
 
@@ -15,7 +17,7 @@ private:
 
   vk::DescriptorSetLayout descriptorSetLayout;
   vk::PipelineLayout pipelineLayout;
-  vk::Pipeline pipeline;
+  std::array<vk::Pipeline, VertexFormatCount> pipelines;   // same layout, one per vertex format
   vk::DescriptorPool descriptorPool;
   vk::DescriptorSet descriptorSet;
 
@@ -23,7 +25,7 @@ private:
 
   void CreateDescriptorPool();
   void CreateDescriptorSetLayout();
-  void CreatePipeline(vk::Extent2D swapChainExtent, vk::RenderPass renderPass);
+  void CreatePipeline(vk::Extent2D swapChainExtent, vk::RenderPass renderPass, InstanceEncoding instanceEncoding);
   
   void Copy(const Pipeline& other);
   void Move(Pipeline& other);
@@ -49,7 +51,7 @@ public:
 
   void UpdateDescriptorSets(std::vector<vk::DescriptorBufferInfo> descriptors);
 
-  vk::Pipeline GetPipeline() const;
+  vk::Pipeline GetPipeline(VertexFormat format = VertexFormat::Float) const;
   vk::PipelineLayout GetPipelineLayout() const;
   vk::DescriptorSet GetDescriptorSet() const;
   vk::DescriptorSet* GetDescriptorSetRef();
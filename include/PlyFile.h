@@ -0,0 +1,92 @@
+#ifndef PLYFILE_H
+#define PLYFILE_H
+#include "stdafx.h"
+#include "Vertex.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <string>
+#include <vector>
+
+BEGIN_LPE
+
+enum class PlyFormat
+{
+  Ascii,
+  BinaryLittleEndian,
+  BinaryBigEndian
+};
+
+enum class PlyType : uint8_t
+{
+  None,
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float32,
+  Float64
+};
+
+struct PlyProperty
+{
+  std::string name;
+  PlyType type = PlyType::None;
+  PlyType countType = PlyType::None; // only set for list properties
+};
+
+struct PlyElement
+{
+  std::string name;
+  uint32_t count = 0;
+  std::vector<PlyProperty> properties;
+};
+
+// reads a (triangulated) ply file into lpe::Vertex / index arrays
+// the layout of the body is taken from the header, so the order of the properties doesn't matter
+class PlyFile
+{
+private:
+  std::string fileName;
+  MappedFile file;
+  PlyFormat format;
+  std::vector<PlyElement> elements;
+  size_t bodyOffset;
+
+  void ParseHeader();
+  uint32_t AllocateOutput(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
+
+  const char* ReadElement(const PlyElement& element, const char* cursor, const char* end, uint32_t first, uint32_t count, uint32_t vertexCount, Vertex* vertices, uint32_t* indices) const;
+
+  const char* ReadBinaryVertices(const PlyElement& element, const char* cursor, const char* end, Vertex* vertices, uint32_t count) const;
+  const char* ReadBinaryFaces(const PlyElement& element, const char* cursor, const char* end, uint32_t* indices, uint32_t count, uint32_t vertexCount) const;
+  const char* SkipBinaryElement(const PlyElement& element, const char* cursor, const char* end) const;
+
+  const char* ReadAsciiVertices(const PlyElement& element, const char* cursor, const char* end, Vertex* vertices, uint32_t count) const;
+  const char* ReadAsciiFaces(const PlyElement& element, const char* cursor, const char* end, uint32_t* indices, uint32_t count, uint32_t vertexCount) const;
+  const char* SkipAsciiElement(const PlyElement& element, const char* cursor, const char* end) const;
+
+public:
+  PlyFile() = default;
+  PlyFile(const PlyFile& other) = delete;
+  PlyFile(PlyFile&& other) = default;
+  PlyFile& operator=(const PlyFile& other) = delete;
+  PlyFile& operator=(PlyFile&& other) = default;
+
+  explicit PlyFile(const std::string& fileName);
+
+  ~PlyFile() = default;
+
+  void Read(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const;
+  // same result as Read(vertices, indices) but the body is split into chunks which are parsed by the pool
+  void Read(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, ThreadPool& pool) const;
+
+  PlyFormat GetFormat() const;
+  bool IsBinary() const;
+  const std::vector<PlyElement>& GetElements() const;
+};
+
+END_LPE
+
+#endif
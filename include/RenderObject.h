@@ -3,54 +3,44 @@
 
 #include "lpe.h"
 #include "Model.h"
-#include <stack>
-#include <unordered_map>
+#include "MeshRegistry.h"
+#include "InstanceStorage.h"
 
 BEGIN_LPE
 
-struct InstanceValue
-{
-  glm::vec3 position;
-  glm::mat4 matrix;
-};
-
-class RenderInstance
+// convenience access to one instance of a RenderObject
+class InstanceRef
 {
 private:
-  std::stack<InstanceValue> values;
-public:
-  RenderInstance();
-  RenderInstance(const RenderInstance& other);
-  RenderInstance(RenderInstance&& other);
-  RenderInstance& operator=(const RenderInstance& other);
-  RenderInstance& operator=(RenderInstance&& other);
-
-  ~RenderInstance() = default;
+  InstanceStorage* storage;
+  InstanceHandle handle;
 
-  InstanceData ToInstanceData();
+public:
+  InstanceRef(InstanceStorage* storage, InstanceHandle handle);
 
-  void ResetTransform();
   void SetTransform(glm::mat4 transform);
   glm::mat4 Transform(glm::mat4 transform);
 
   void SetPosition(glm::vec3 pos);
   void Move(glm::vec3 delta);
 
-  void Push();
-  void Pop();
+  void SetVisible(bool visible);
+  void SetStatic(bool isStatic);
 
   glm::vec3 GetPosition() const;
   glm::mat4 GetTransform() const;
+  bool IsVisible() const;
+  bool IsStatic() const;
+
+  InstanceHandle GetHandle() const;
 };
 
-class Deleter
+enum class LoadMode
 {
-public:
-  void operator()(RenderInstance* instance) const {}
+  Blocking,
+  Async   // the mesh is parsed in the background, see RenderObject::IsLoaded
 };
 
-using InstanceRef = std::unique_ptr<RenderInstance, Deleter>;
-
 class RenderObject
 {
 private:
@@ -58,11 +48,9 @@ private:
   int32_t vertexOffset;
   uint32_t indexOffset;
 
-  std::unordered_map<uint32_t, RenderInstance> instances;
-  std::vector<uint32_t> indices;
-  std::vector<lpe::Vertex> vertices;
-
-  void Load(std::string fileName);
+  InstanceStorage instances;
+  std::shared_ptr<const Mesh> mesh;
+  MeshFuture pendingMesh;
 
 public:
   RenderObject() = default;
@@ -71,22 +59,31 @@ public:
   RenderObject& operator=(const RenderObject& other);
   RenderObject& operator=(RenderObject&& other) noexcept;
 
-  RenderObject(std::string path, uint32_t prio);
+  RenderObject(std::string path, uint32_t prio, LoadMode mode = LoadMode::Blocking, MeshOptions options = {});
+  // draws geometry which didn't come from MeshRegistry, like the chunks of StaticBaker
+  RenderObject(std::shared_ptr<const Mesh> mesh, uint32_t prio);
+
+  // true as soon as the mesh is available, rethrows the error if loading failed
+  bool IsLoaded();
 
   void SetOffsets(uint32_t indexOffset, int32_t vertexOffset);
 
-  InstanceRef GetInstance(uint32_t id = 0);
-  void EreaseInstance(uint32_t id);
+  InstanceHandle AddInstance();
+  void AddInstances(uint32_t count, std::vector<InstanceHandle>& handles);
+  void RemoveInstance(InstanceHandle handle);
+  InstanceRef GetInstance(InstanceHandle handle);
+  // bulk updates, see InstanceStorage::SetTransforms and InstanceStorage::MapTransforms
+  InstanceStorage& GetInstances();
 
-  vk::DrawIndexedIndirectCommand GetIndirectCommand(uint32_t existingInstances) const;
-  std::vector<InstanceData> GetInstanceData();
+  // draws instanceCount instances of the given level of detail, starting at firstInstance in the instance buffer
+  vk::DrawIndexedIndirectCommand GetIndirectCommand(uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) const;
+  // appends the visible instances and their animations, GetInstanceCount of each
+  void GetInstanceData(std::vector<InstanceData>& instanceData, std::vector<AnimationData>& animationData) const;
 
   uint32_t GetInstanceCount() const;
+  uint32_t GetLodCount() const;
 
-  std::vector<Vertex>::iterator GetVertexBegin();
-  std::vector<Vertex>::iterator GetVertexEnd();
-  std::vector<uint32_t>::iterator GetIndexBegin();
-  std::vector<uint32_t>::iterator GetIndexEnd();
+  std::shared_ptr<const Mesh> GetMesh() const;
 };
 
 END_LPE
@@ -0,0 +1,82 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+#include "stdafx.h"
+#include "InstanceStorage.h"
+#include <vector>
+
+BEGIN_LPE
+
+// same rules as InstanceHandle, a removed node's handle never points to a new one
+struct SceneNode
+{
+  uint32_t slot = UINT32_MAX;
+  uint32_t generation = 0;
+};
+
+// parent/child transforms, world = world of the parent * local
+// the nodes are stored breadth first, so parents come before their children and siblings are next to each other
+// Update only walks the subtrees below changed nodes and writes their world matrices to the attached instances
+class SceneGraph
+{
+private:
+  static const uint32_t None = UINT32_MAX;
+
+  struct Slot
+  {
+    uint32_t linear;
+    uint32_t generation;
+    uint32_t parent;                 // slot of the parent
+    std::vector<uint32_t> children;  // slots
+    bool alive;
+  };
+
+  std::vector<Slot> slots;
+  std::vector<uint32_t> freeSlots;
+
+  // linear arrays in breadth first order
+  std::vector<glm::mat4> locals;
+  std::vector<glm::mat4> worlds;
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> firstChildren;
+  std::vector<uint32_t> childCounts;
+  std::vector<InstanceStorage*> storages;
+  std::vector<InstanceHandle> instances;
+  std::vector<uint32_t> slotOfLinear;
+
+  // linear indices of nodes whose local transform changed since the last Update
+  std::vector<uint32_t> dirty;
+  std::vector<uint32_t> updated;
+  std::vector<uint32_t> pending;
+  uint32_t updateCount = 0;
+
+  // added or removed nodes are appended or left behind until Update restores the order
+  bool structureChanged = false;
+
+  uint32_t GetLinear(SceneNode node) const;
+  void Linearize();
+
+public:
+  // the node is a root without a valid parent
+  SceneNode Add(SceneNode parent = {});
+  // removes the node with its subtree, their instances keep their last transform
+  void Remove(SceneNode node);
+  bool IsValid(SceneNode node) const;
+
+  void SetLocal(SceneNode node, const glm::mat4& local);
+  glm::mat4 GetLocal(SceneNode node) const;
+  // as of the last Update
+  glm::mat4 GetWorld(SceneNode node) const;
+
+  // the instance follows the world transform of the node, its own position is reset
+  void Attach(SceneNode node, InstanceStorage& storage, InstanceHandle instance);
+  void Detach(SceneNode node);
+
+  // recomputes the changed subtrees, nothing happens if no node changed
+  void Update();
+
+  uint32_t GetCount() const;
+};
+
+END_LPE
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef STAGINGRING_H
+#define STAGINGRING_H
+#include "stdafx.h"
+#include "Buffer.h"
+#include <array>
+
+BEGIN_LPE
+
+// one persistently mapped buffer every upload is staged in, created once at startup
+// uploads are recorded into one of FrameCount command buffers, a range of the ring is reused once the fence of its submission signaled
+// staging and submitting doesn't create any vulkan objects
+class StagingRing
+{
+public:
+  static const uint32_t FrameCount = 2;
+  static const vk::DeviceSize DefaultSize = 8 * 1024 * 1024;
+  static const vk::DeviceSize Alignment = 16;
+
+private:
+  struct Frame
+  {
+    vk::CommandBuffer commandBuffer;
+    vk::Fence fence;
+    vk::DeviceSize end = 0;   // head of the ring when the frame was submitted
+    bool pending = false;     // submitted and not retired yet
+  };
+
+  std::unique_ptr<vk::Device> device;
+  std::unique_ptr<vk::Queue> queue;
+  vk::CommandPool commandPool;
+
+  Buffer buffer;
+  vk::DeviceSize size;
+
+  // bytes staged and retired since startup, their position in the ring is taken modulo size
+  vk::DeviceSize head = 0;
+  vk::DeviceSize tail = 0;
+
+  std::array<Frame, FrameCount> frames;
+  uint32_t current = 0;
+  bool recording = false;
+
+  // copies into one target which weren't recorded yet, so consecutive ranges end up in a single copy command
+  Buffer* copyTarget = nullptr;
+  std::vector<vk::BufferCopy> copies;
+
+  void Begin();
+  void RecordCopies();
+  // frames are retired in the order they were submitted, wait blocks on the oldest one if it isn't done yet
+  bool RetireOldest(bool wait);
+  bool Allocate(vk::DeviceSize bytes, vk::DeviceSize& offset);
+  vk::DeviceSize Stage(const uint8_t* data, vk::DeviceSize bytes);
+
+public:
+  StagingRing(const StagingRing& other) = delete;
+  StagingRing(StagingRing&& other) = delete;
+  StagingRing& operator=(const StagingRing& other) = delete;
+  StagingRing& operator=(StagingRing&& other) = delete;
+
+  StagingRing(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::Queue* queue, vk::CommandPool commandPool, vk::DeviceSize size = DefaultSize);
+
+  ~StagingRing();
+
+  // the command buffer the uploads are recorded into, for work which depends on them
+  // only valid until the next Upload, which may have to submit it to make room
+  vk::CommandBuffer GetCommandBuffer();
+
+  // copies the source ranges of the regions from data, which has the same layout as target, into target
+  // ranges larger than the ring are split up
+  void Upload(Buffer& target, const void* data, const std::vector<vk::BufferCopy>& regions);
+  void Upload(Buffer& target, const void* data, vk::DeviceSize size);
+
+  // doesn't wait, later submissions to the same queue see the uploaded data
+  void Submit();
+  // submits and waits for every upload
+  void Flush();
+
+  vk::DeviceSize GetSize() const;
+};
+
+END_LPE
+
+#endif
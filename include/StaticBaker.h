@@ -0,0 +1,50 @@
+#ifndef STATICBAKER_H
+#define STATICBAKER_H
+#include "stdafx.h"
+#include "Mesh.h"
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+BEGIN_LPE
+
+// merges static instances (see InstanceFlags::Static) into world space meshes, one per cell of a uniform grid and vertex format
+// an instance belongs to the cell of its bounding sphere's center, so chunks reach a bit over their cell's borders
+class StaticBaker
+{
+private:
+  // cell coordinates and vertex format
+  using ChunkKey = std::tuple<int32_t, int32_t, int32_t, uint32_t>;
+
+  struct Chunk
+  {
+    std::shared_ptr<Mesh> mesh;
+    std::unordered_set<glm::vec3> colors;   // of palette chunks, they have to fit into one palette
+  };
+
+  float chunkSize;
+  std::map<ChunkKey, std::vector<Chunk>> chunks;
+  std::unordered_map<const Mesh*, std::vector<Vertex>> unpacked;
+
+  const std::vector<Vertex>& Unpack(const Mesh& mesh);
+
+public:
+  // chunks stay small enough for 16 bit indices, a single larger mesh gets a chunk of its own
+  // palette chunks also stay within Palette::MaxColors
+  static const uint32_t MaxVertices = 65536;
+
+  explicit StaticBaker(float chunkSize = 32.0f);
+
+  // adds the full mesh (Mesh::lods[0]) transformed by the instance's matrix
+  void Add(const Mesh& mesh, const InstanceData& instance);
+
+  // the chunks in the vertex format of the meshes they were merged from, with a single level of detail
+  // the baker is empty afterwards
+  std::vector<std::shared_ptr<const Mesh>> Build();
+};
+
+END_LPE
+
+#endif
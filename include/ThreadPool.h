@@ -0,0 +1,86 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include "stdafx.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+BEGIN_LPE
+
+class ThreadPool
+{
+private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping = false;
+
+  void Work();
+
+public:
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool(ThreadPool&& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+  ThreadPool& operator=(ThreadPool&& other) = delete;
+
+  explicit ThreadPool(uint32_t threadCount);
+
+  ~ThreadPool();
+
+  template <typename Function>
+  std::future<typename std::result_of<Function()>::type> Enqueue(Function&& function);
+
+  // waits for a task of this pool but executes queued tasks in the meantime,
+  // so it is safe to wait from inside of a worker
+  template <typename T>
+  T Wait(std::future<T>& future);
+
+  bool RunPendingTask();
+
+  uint32_t GetThreadCount() const;
+
+  // pool with one worker per hardware thread, created on first use
+  static ThreadPool& Shared();
+};
+
+template <typename Function>
+std::future<typename std::result_of<Function()>::type> ThreadPool::Enqueue(Function&& function)
+{
+  using Result = typename std::result_of<Function()>::type;
+
+  // std::function needs a copyable target
+  auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+  auto future = task->get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.emplace([task]() { (*task)(); });
+  }
+
+  condition.notify_one();
+
+  return future;
+}
+
+template <typename T>
+T ThreadPool::Wait(std::future<T>& future)
+{
+  while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    if (!RunPendingTask())
+    {
+      // nothing left to help with, the task is already running somewhere else
+      future.wait();
+    }
+  }
+
+  return future.get();
+}
+
+END_LPE
+
+#endif
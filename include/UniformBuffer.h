@@ -6,6 +6,7 @@
 #include "Model.h"
 #include "Camera.h"
 #include "UniformBufferObject.h"
+#include "InstanceBuilder.h"
 
 BEGIN_LPE
 
@@ -22,6 +23,36 @@ private:
   Buffer viewBuffer;
 	Buffer instanceBuffer;
 
+  // holds Palette::MaxColors colors, rewritten whenever the shared palette changed
+  Buffer paletteBuffer;
+  uint32_t paletteVersion = 0;
+
+  // the instance buffer holds the instances in this encoding, the pipeline decodes them accordingly
+  InstanceEncoding instanceEncoding = InstanceEncoding::Matrix;
+  std::vector<uint8_t> encodedInstances;
+
+  // with a builder the encoded instances go to instanceParameters and the instance buffer holds the matrices built from them
+  InstanceBuilder* instanceBuilder = nullptr;
+  Buffer instanceParameters;
+
+  // the instances the renderer wrote again this frame, only they are encoded and compared
+  std::vector<InstanceRange> changedInstances;
+
+  // mirrors the uploaded instances, only instances which differ from the last upload are staged (see StagingRing)
+  std::vector<uint8_t> uploadedInstances;
+  std::vector<vk::BufferCopy> dirtyRanges;
+  // the dirty ranges in instances, with a builder only their matrices are built again
+  std::vector<InstanceRange> builtRanges;
+
+  // binding 2, the animations of the instances in the same order, evaluated with ubo.time
+  Buffer animationBuffer;
+  std::vector<uint8_t> uploadedAnimations;
+  std::vector<vk::BufferCopy> animationRanges;
+
+  // lists the parts of the changed instances in data which differ from uploaded in ranges, uploaded is updated
+  // all of data is listed if the buffer was recreated
+  void FindChanges(const void* data, vk::DeviceSize size, vk::DeviceSize stride, bool recreated, std::vector<uint8_t>& uploaded, std::vector<vk::BufferCopy>& ranges);
+
 public:
   UniformBuffer() = default;
   UniformBuffer(const UniformBuffer& other);
@@ -29,17 +60,24 @@ public:
   UniformBuffer& operator=(const UniformBuffer& other);
   UniformBuffer& operator=(UniformBuffer&& other);
 
-  UniformBuffer(vk::PhysicalDevice physicalDevice, vk::Device* device, ModelsRenderer& modelsRenderer, const Camera& camera, const Commands& commands);
+  UniformBuffer(vk::PhysicalDevice physicalDevice, vk::Device* device, ModelsRenderer& modelsRenderer, const Camera& camera, const Commands& commands, InstanceEncoding instanceEncoding = InstanceEncoding::Matrix, InstanceBuilder* instanceBuilder = nullptr);
 
   ~UniformBuffer();
 
-  void Update(const Camera& camera, ModelsRenderer& renderer, const Commands& commands);
+  // returns true if the instance or animation buffer was recreated, the command buffers bind them and have to be recorded again
+  bool Update(const Camera& camera, ModelsRenderer& renderer, const Commands& commands);
 
+  // view, instance and palette buffer
   std::vector<vk::DescriptorBufferInfo> GetDescriptors();
 
   void SetLightPosition(glm::vec3 light);
+  // seconds, drives the instance animations
+  void SetTime(float time);
 
+  // encoding of the instance buffer as the vertex shaders see it, always Matrix with an InstanceBuilder
+  InstanceEncoding GetInstanceEncoding() const;
 	vk::Buffer GetInstanceBuffer();
+  vk::Buffer GetAnimationBuffer();
 };
 
 END_LPE
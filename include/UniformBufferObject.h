@@ -10,6 +10,7 @@ struct UniformBufferObject
   glm::mat4 projection;
   glm::mat4 view;
   glm::vec3 lightPos;
+  float time = 0.0f;   // fills the padding after lightPos
 };
 
 END_LPE
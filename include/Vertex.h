@@ -9,6 +9,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
 #include "stdafx.h"
+#include "InstanceEncoding.h"
+#include "InstanceAnimation.h"
 
 BEGIN_LPE
   struct Vertex
@@ -21,13 +23,72 @@ BEGIN_LPE
     Vertex() = default;
     Vertex(std::initializer_list<glm::vec3> list);
 
-    static std::vector<vk::VertexInputBindingDescription> GetBindingDescription();
+    static std::vector<vk::VertexInputBindingDescription> GetBindingDescription(InstanceEncoding encoding = InstanceEncoding::Matrix);
 
-    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions();
+    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions(InstanceEncoding encoding = InstanceEncoding::Matrix);
 
     bool operator==(const Vertex& other) const;
   };
 
+  enum class VertexFormat : uint32_t
+  {
+    Float,    // Vertex
+    Packed,   // PackedVertex
+    Flat,     // FlatVertex
+    Palette,  // PaletteVertex
+    Count
+  };
+
+  const uint32_t VertexFormatCount = static_cast<uint32_t>(VertexFormat::Count);
+
+  // 16 byte vertex, positions are quantized relative to the bounding sphere of their mesh
+  // the instance matrices of quantized meshes undo the quantization (see ModelsRenderer::UpdateInstanceData)
+  struct PackedVertex
+  {
+    int16_t position[4];   // snorm, w is always 1
+    int16_t normal[2];     // snorm, octahedral encoding
+    uint8_t color[4];      // unorm
+
+    static PackedVertex Pack(const Vertex& vertex, glm::vec3 center, float radius);
+    Vertex Unpack(glm::vec3 center, float radius) const;
+
+    static std::vector<vk::VertexInputBindingDescription> GetBindingDescription(InstanceEncoding encoding = InstanceEncoding::Matrix);
+
+    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions(InstanceEncoding encoding = InstanceEncoding::Matrix);
+  };
+
+  // 12 byte vertex for flat shaded meshes, quantized like PackedVertex
+  // the fragment shader derives the face normal from the screen space derivatives of the position
+  struct FlatVertex
+  {
+    int16_t position[4];   // snorm, w is always 1
+    uint8_t color[4];      // unorm
+
+    static FlatVertex Pack(const Vertex& vertex, glm::vec3 center, float radius);
+    Vertex Unpack(glm::vec3 center, float radius) const;
+
+    static std::vector<vk::VertexInputBindingDescription> GetBindingDescription(InstanceEncoding encoding = InstanceEncoding::Matrix);
+
+    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions(InstanceEncoding encoding = InstanceEncoding::Matrix);
+  };
+
+  // 8 byte vertex, flat shaded like FlatVertex with its color looked up in lpe::Palette
+  struct PaletteVertex
+  {
+    int16_t position[3];   // snorm, quantized like PackedVertex
+    uint16_t color;        // into Mesh::palette, replaced by an index into the shared palette when uploaded
+
+    static PaletteVertex Pack(const Vertex& vertex, glm::vec3 center, float radius, uint16_t color);
+    // palette holds the colors of the vertex's mesh
+    Vertex Unpack(glm::vec3 center, float radius, const std::vector<glm::vec3>& palette) const;
+
+    static std::vector<vk::VertexInputBindingDescription> GetBindingDescription(InstanceEncoding encoding = InstanceEncoding::Matrix);
+
+    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions(InstanceEncoding encoding = InstanceEncoding::Matrix);
+  };
+
+  uint32_t GetVertexStride(VertexFormat format);
+
 END_LPE
 
 namespace std
@@ -0,0 +1,33 @@
+#ifndef VERTEXWELDER_H
+#define VERTEXWELDER_H
+#include "stdafx.h"
+#include "Vertex.h"
+#include <vector>
+
+BEGIN_LPE
+
+// collapses duplicated vertices and remaps the indices to the remaining ones
+// uses an open addressing table over the vertex array itself, so welding never allocates per vertex
+// the tables are kept between calls, reuse one welder to weld several meshes
+class VertexWelder
+{
+private:
+  float epsilon;
+  std::vector<uint32_t> table;
+  std::vector<uint32_t> remap;
+
+  size_t Hash(const Vertex& vertex) const;
+  bool Equal(const Vertex& a, const Vertex& b) const;
+
+public:
+  // with an epsilon > 0 vertices whose attributes round to the same multiple of epsilon are welded
+  // the first vertex of each group is kept
+  explicit VertexWelder(float epsilon = 0.0f);
+
+  // returns the number of remaining vertices
+  uint32_t Weld(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+};
+
+END_LPE
+
+#endif
@@ -18,11 +18,14 @@ BEGIN_LPE
 		uint32_t height;
 		std::string title;
 		bool resizeable;
+		lpe::InstanceEncoding instanceEncoding = lpe::InstanceEncoding::Matrix;
+		bool buildInstancesOnGpu = false;
 		lpe::Camera defaultCamera;
 		lpe::Instance instance;
 		lpe::Device device;
 		lpe::SwapChain swapChain;
 		lpe::Commands commands;
+		lpe::InstanceBuilder instanceBuilder;
 		lpe::UniformBuffer uniformBuffer;
 		lpe::Pipeline graphicsPipeline;
 		lpe::ImageView depthImage;
@@ -52,11 +55,13 @@ BEGIN_LPE
 		Window operator=(const Window& window) const = delete;
 		Window operator=(Window&& window) const = delete;
 
-		Window(uint32_t width, uint32_t height, std::string title, bool resizeable = false);
+		Window(uint32_t width, uint32_t height, std::string title, bool resizeable = false, InstanceEncoding instanceEncoding = InstanceEncoding::Matrix, bool buildInstancesOnGpu = false);
 		virtual ~Window();
 
 		// TODO: add functions for imgui stuff and further methods to preinit window!
-		void Create(uint32_t width, uint32_t height, std::string title, bool resizeable = false);
+		// instances are uploaded every frame, the smaller encodings trade precision (see InstanceEncoding) for bandwidth
+		// buildInstancesOnGpu decodes them once per instance in a compute pass (see InstanceBuilder) instead of in every vertex
+		void Create(uint32_t width, uint32_t height, std::string title, bool resizeable = false, InstanceEncoding instanceEncoding = InstanceEncoding::Matrix, bool buildInstancesOnGpu = false);
 
 		lpe::Camera CreateCamera(glm::vec3 position, glm::vec3 lookAt = {0, 0, 0}, float fov = 60, float near = 0.0, float far = 10) const;
 
@@ -10,10 +10,25 @@ layout (location = 3) in vec3 light;
 
 layout (location = 0) out vec4 outColor;
 
+// set for meshes without normals, see FlatVertex
+layout (constant_id = 0) const bool flatShading = false;
+
+vec3 FaceNormal()
+{
+	// light and view are the world and view space positions relative to something constant,
+	// their derivatives span the triangle's plane
+	vec3 normal = normalize(cross(dFdx(light), dFdy(light)));
+	vec3 viewNormal = cross(dFdx(view), dFdy(view));
+
+	// the view matrix doesn't mirror, so both crosses have the same orientation
+	// the normal has to point towards the camera, which sits at the origin of view space
+	return dot(viewNormal, view) > 0.0 ? -normal : normal;
+}
+
 void main() 
 {
 //	outColor = vec4(inColor, 1.0);
-	vec3 N = normalize(inNormal);
+	vec3 N = flatShading ? FaceNormal() : normalize(inNormal);
 	vec3 L = normalize(light);
 	vec3 V = normalize(view);
 	vec3 R = reflect(L, N);
@@ -2,23 +2,20 @@
 
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec3 inColor;
 
-layout (location = 3) in vec4 inRow1;
-layout (location = 4) in vec4 inRow2;
-layout (location = 5) in vec4 inRow3;
-layout (location = 6) in vec4 inRow4;
-
-//layout (location = 3) in mat4 inMatrix;
+#include "instance.glsl"
 
 layout (binding = 0) uniform UboView 
 {
 	mat4 projection;
 	mat4 view;
 	vec3 lightPos;
+	float time;
 } uboView;
 
 
@@ -34,11 +31,7 @@ out gl_PerVertex
 
 void main() 
 {
-	mat4 inMatrix;
-	inMatrix[0] = inRow1;
-	inMatrix[1] = inRow2;
-	inMatrix[2] = inRow3;
-	inMatrix[3] = inRow4;
+	mat4 inMatrix = GetAnimationMatrix(uboView.time) * GetInstanceMatrix();
 
 	vec4 worldPos = inMatrix * vec4(inPos, 1.0);
 
@@ -0,0 +1,46 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : require
+
+// FlatVertex, the position is relative to the bounding sphere of the mesh
+// the instance matrix already contains the scale and offset to undo that
+layout (location = 0) in vec4 inPos;
+layout (location = 2) in vec4 inColor;
+
+#include "instance.glsl"
+
+layout (binding = 0) uniform UboView 
+{
+	mat4 projection;
+	mat4 view;
+	vec3 lightPos;
+	float time;
+} uboView;
+
+
+layout (location = 0) out vec3 outColor;
+layout (location = 1) out vec3 outNormal;
+layout (location = 2) out vec3 view;
+layout (location = 3) out vec3 light;
+
+out gl_PerVertex 
+{
+	vec4 gl_Position;   
+};
+
+void main() 
+{
+	mat4 inMatrix = GetAnimationMatrix(uboView.time) * GetInstanceMatrix();
+
+	vec4 worldPos = inMatrix * vec4(inPos.xyz, 1.0);
+
+	// base.frag derives the face normal when flat shading
+	outColor = inColor.rgb;
+	outNormal = vec3(0.0);
+	light = uboView.lightPos - worldPos.xyz;
+	view = (uboView.view * worldPos).xyz;
+
+	gl_Position = uboView.projection * uboView.view * worldPos;
+}
@@ -0,0 +1,64 @@
+// decodes every InstanceEncoding, the pipeline sets the specialization constant to the one in use
+// each encoding provides all four locations, the unused ones are ignored
+
+layout (constant_id = 1) const uint instanceEncoding = 0u;
+
+layout (location = 3) in vec4 inInstance0;
+layout (location = 4) in vec4 inInstance1;
+layout (location = 5) in vec4 inInstance2;
+layout (location = 6) in vec4 inInstance3;
+
+// AnimationData, binding 2
+layout (location = 7) in vec4 inAnimation0;   // pivot, type
+layout (location = 8) in vec4 inAnimation1;   // axis, speed
+layout (location = 9) in vec4 inAnimation2;   // phase, amplitude
+
+#include "quaternion.glsl"
+
+mat4 GetInstanceMatrix()
+{
+	// Affine, the three upper rows
+	if (instanceEncoding == 1u)
+	{
+		return transpose(mat4(inInstance0, inInstance1, inInstance2, vec4(0.0, 0.0, 0.0, 1.0)));
+	}
+
+	// PositionRotationScale and QuantizedPositionRotationScale, the vertex input already expanded the halfs and snorms
+	if (instanceEncoding == 2u || instanceEncoding == 3u)
+	{
+		mat3 rotationScale = QuaternionMatrix(inInstance1) * inInstance0.w;
+
+		return mat4(vec4(rotationScale[0], 0.0), vec4(rotationScale[1], 0.0), vec4(rotationScale[2], 0.0), vec4(inInstance0.xyz, 1.0));
+	}
+
+	// Matrix
+	return mat4(inInstance0, inInstance1, inInstance2, inInstance3);
+}
+
+// AnimationType in world space, the rotations turn around the instance's position
+mat4 GetAnimationMatrix(float time)
+{
+	uint type = uint(inAnimation0.w);
+	vec3 pivot = inAnimation0.xyz;
+	vec3 axis = inAnimation1.xyz;
+	float speed = inAnimation1.w;
+	float wave = inAnimation2.y * sin(speed * time + inAnimation2.x);
+
+	// Bob
+	if (type == 2u)
+	{
+		return mat4(vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0), vec4(axis * wave, 1.0));
+	}
+
+	// Spin and Sway
+	if (type == 1u || type == 3u)
+	{
+		float angle = type == 1u ? speed * time + inAnimation2.x : wave;
+		mat3 rotation = QuaternionMatrix(vec4(axis * sin(angle * 0.5), cos(angle * 0.5)));
+
+		return mat4(vec4(rotation[0], 0.0), vec4(rotation[1], 0.0), vec4(rotation[2], 0.0), vec4(pivot - rotation * pivot, 1.0));
+	}
+
+	// None
+	return mat4(1.0);
+}
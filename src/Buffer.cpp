@@ -15,16 +15,19 @@ void lpe::Buffer::CreateBuffer(vk::DeviceSize size,
 
   vk::MemoryRequirements requirements = device->getBufferMemoryRequirements(buffer);
 
-  vk::MemoryAllocateInfo allocInfo = { requirements.size, helper::FindMemoryTypeIndex(requirements.memoryTypeBits, properties, physicalDevice.getMemoryProperties()) };
+  memory = MemoryAllocator::Shared().Allocate(physicalDevice, *device, requirements, properties);
 
-  result = device->allocateMemory(&allocInfo, nullptr, &memory);
-  
-  if (result != vk::Result::eSuccess)
+  device->bindBufferMemory(buffer, memory.memory, memory.offset);
+}
+
+uint8_t* lpe::Buffer::GetMapped() const
+{
+  if (!memory.mapped)
   {
-    throw std::runtime_error("Failed to allocate buffer memory!" + vk::to_string(result) + "");
+    throw std::runtime_error("Buffer memory is not host visible!");
   }
 
-  device->bindBufferMemory(buffer, memory, 0);
+  return static_cast<uint8_t*>(memory.mapped);
 }
 
 lpe::Buffer::Buffer(const Buffer& other)
@@ -35,7 +38,6 @@ lpe::Buffer::Buffer(const Buffer& other)
   this->buffer = other.buffer;
   this->memory = other.memory;
   this->descriptor = other.descriptor;
-  this->mapped = other.mapped;
 }
 
 lpe::Buffer::Buffer(Buffer&& other) noexcept
@@ -47,7 +49,6 @@ lpe::Buffer::Buffer(Buffer&& other) noexcept
   this->buffer = other.buffer;
   this->memory = other.memory;
   this->descriptor = other.descriptor;
-  this->mapped = other.mapped;
 }
 
 lpe::Buffer& lpe::Buffer::operator=(const Buffer& other)
@@ -58,7 +59,6 @@ lpe::Buffer& lpe::Buffer::operator=(const Buffer& other)
   this->buffer = other.buffer;
   this->memory = other.memory;
   this->descriptor = other.descriptor;
-  this->mapped = other.mapped;
 
   return *this;
 }
@@ -73,15 +73,13 @@ lpe::Buffer& lpe::Buffer::operator=(Buffer&& other) noexcept
   this->buffer = other.buffer;
   this->memory = other.memory;
   this->descriptor = other.descriptor;
-  this->mapped = other.mapped;
 
   return *this;
 }
 
 lpe::Buffer::Buffer(vk::PhysicalDevice physicalDevice, vk::Device* device)
   : physicalDevice(physicalDevice),
-    size(VK_WHOLE_SIZE),
-    mapped(nullptr)
+    size(VK_WHOLE_SIZE)
 {
   this->device.reset(device);
 
@@ -101,9 +99,7 @@ lpe::Buffer::Buffer(vk::PhysicalDevice physicalDevice,
 
   CreateBuffer(size, usage, properties);
 
-  this->device->mapMemory(memory, 0, size, {}, &mapped);
-  memcpy(mapped, data, (size_t)size);
-  this->device->unmapMemory(memory);
+  memcpy(GetMapped(), data, (size_t)size);
 
   descriptor = vk::DescriptorBufferInfo{buffer, 0, VK_WHOLE_SIZE};
 }
@@ -132,13 +128,28 @@ lpe::Buffer::~Buffer()
       device->destroyBuffer(buffer);
     }
 
-    if(memory)
+    MemoryAllocator::Shared().Free(memory);
+
+    device.release();
+  }
+}
+
+void lpe::Buffer::Destroy()
+{
+  if(device)
+  {
+    if(buffer)
     {
-      device->freeMemory(memory);
+      device->destroyBuffer(buffer);
     }
 
-    device.release();
+    MemoryAllocator::Shared().Free(memory);
   }
+
+  buffer = nullptr;
+  memory = {};
+  size = 0;
+  descriptor = vk::DescriptorBufferInfo{ buffer, 0, VK_WHOLE_SIZE };
 }
 
 void lpe::Buffer::CreateHostVisible(vk::DeviceSize size, void* data, vk::BufferUsageFlags usage)
@@ -147,23 +158,17 @@ void lpe::Buffer::CreateHostVisible(vk::DeviceSize size, void* data, vk::BufferU
 
   CreateBuffer(size, usage, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
 
-  this->device->mapMemory(memory, 0, size, {}, &mapped);
-  memcpy(mapped, data, (size_t)size);
-  this->device->unmapMemory(memory);
+  memcpy(GetMapped(), data, (size_t)size);
 }
 
 void lpe::Buffer::CreateStaged(const Commands& commands, vk::DeviceSize size, void* data, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties)
 {
-  Buffer staging = { physicalDevice, device.get(), data, size };
-
   this->size = size;
   CreateBuffer(size, usage, properties);
 
-  auto commandBuffer = commands.BeginSingleTimeCommands();
-
-  Copy(staging, commandBuffer);
-
-  commands.EndSingleTimeCommands(commandBuffer);
+  auto& stagingRing = commands.GetStagingRing();
+  stagingRing.Upload(*this, data, size);
+  stagingRing.Flush();
 }
 
 void lpe::Buffer::Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer) const
@@ -178,18 +183,39 @@ void lpe::Buffer::Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer) const
   commandBuffer.copyBuffer(src.buffer, buffer, 1, &copyRegion);
 }
 
-void lpe::Buffer::CopyStaged(vk::CommandBuffer& commandBuffer, void* data)
+void lpe::Buffer::Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer, vk::DeviceSize srcOffset, vk::DeviceSize dstOffset, vk::DeviceSize size) const
 {
-  Buffer staging = { physicalDevice, device.get(), data, size };
+  if(srcOffset + size > src.size || dstOffset + size > this->size)
+  {
+    throw std::runtime_error("Copy region exceeds the buffer size");
+  }
+
+  vk::BufferCopy copyRegion = { srcOffset, dstOffset, size };
+
+  commandBuffer.copyBuffer(src.buffer, buffer, 1, &copyRegion);
+}
+
+void lpe::Buffer::Copy(lpe::Buffer& src, vk::CommandBuffer& commandBuffer, const std::vector<vk::BufferCopy>& regions) const
+{
+  for (const auto& region : regions)
+  {
+    if (region.srcOffset + region.size > src.size || region.dstOffset + region.size > this->size)
+    {
+      throw std::runtime_error("Copy region exceeds the buffer size");
+    }
+  }
 
-  Copy(staging, commandBuffer);
+  commandBuffer.copyBuffer(src.buffer, buffer, (uint32_t)regions.size(), regions.data());
+}
+
+void lpe::Buffer::CopyStaged(StagingRing& stagingRing, void* data)
+{
+  stagingRing.Upload(*this, data, size);
 }
 
 void lpe::Buffer::CopyToBufferMemory(void* data, size_t size)
 {
-  device->mapMemory(memory, 0, size, {}, &mapped);
-  memcpy(mapped, data, size);
-  device->unmapMemory(memory);
+  memcpy(GetMapped(), data, size);
 }
 
 void lpe::Buffer::CopyToBufferMemory(void* data)
@@ -197,14 +223,24 @@ void lpe::Buffer::CopyToBufferMemory(void* data)
   CopyToBufferMemory(data, size);
 }
 
+void lpe::Buffer::CopyToBufferMemory(const void* data, const std::vector<vk::BufferCopy>& regions)
+{
+  auto mapped = GetMapped();
+
+  for (const auto& region : regions)
+  {
+    memcpy(mapped + region.srcOffset, static_cast<const uint8_t*>(data) + region.srcOffset, (size_t)region.size);
+  }
+}
+
 vk::Buffer lpe::Buffer::GetBuffer()
 {
   return buffer;
 }
 
-vk::DeviceMemory* lpe::Buffer::GetMemory()
+const lpe::MemoryAllocation& lpe::Buffer::GetMemory() const
 {
-  return &memory;
+  return memory;
 }
 
 vk::DescriptorBufferInfo lpe::Buffer::GetDescriptor()
@@ -11,6 +11,7 @@ lpe::Commands::Commands(const Commands& other)
   this->physicalDevice = other.physicalDevice;
   this->commandPool = other.commandPool;
   this->commandBuffers = { other.commandBuffers };
+  this->stagingRing = other.stagingRing;
 }
 
 lpe::Commands::Commands(Commands&& other) noexcept
@@ -24,6 +25,7 @@ lpe::Commands::Commands(Commands&& other) noexcept
   this->physicalDevice = other.physicalDevice;
   this->commandPool = other.commandPool;
   this->commandBuffers = std::move(other.commandBuffers);
+  this->stagingRing = std::move(other.stagingRing);
 }
 
 lpe::Commands& lpe::Commands::operator=(const Commands& other)
@@ -34,6 +36,7 @@ lpe::Commands& lpe::Commands::operator=(const Commands& other)
   this->physicalDevice = other.physicalDevice;
   this->commandPool = other.commandPool;
   this->commandBuffers = { other.commandBuffers };
+  this->stagingRing = other.stagingRing;
 
   return *this;
 }
@@ -49,11 +52,12 @@ lpe::Commands& lpe::Commands::operator=(Commands&& other) noexcept
   this->physicalDevice = other.physicalDevice;
   this->commandPool = other.commandPool;
   this->commandBuffers = std::move(other.commandBuffers);
+  this->stagingRing = std::move(other.stagingRing);
 
   return *this;
 }
 
-lpe::Commands::Commands(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::Queue* graphicsQueue, uint32_t graphicsFamilyIndex)
+lpe::Commands::Commands(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::Queue* graphicsQueue, uint32_t graphicsFamilyIndex, vk::DeviceSize stagingSize)
   : physicalDevice(physicalDevice)
 {
   this->device.reset(device);
@@ -63,6 +67,8 @@ lpe::Commands::Commands(vk::PhysicalDevice physicalDevice, vk::Device* device, v
 
   auto result = this->device->createCommandPool(&createInfo, nullptr, &commandPool);
   helper::ThrowIfNotSuccess(result, "Failed to create graphics CommandPool!");
+
+  stagingRing = std::make_shared<StagingRing>(physicalDevice, device, graphicsQueue, commandPool, stagingSize);
 }
 
 lpe::Commands::~Commands()
@@ -74,6 +80,9 @@ lpe::Commands::~Commands()
 
   if(device)
   {
+    // its command buffers come from the pool
+    stagingRing.reset();
+
     if (!commandBuffers.empty())
     {
       device->freeCommandBuffers(commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
@@ -106,6 +115,12 @@ void lpe::Commands::CreateCommandBuffers(const std::vector<vk::Framebuffer>& fra
                                          ModelsRenderer& renderer, 
 																				 UniformBuffer& ubo)
 {
+  if (!commandBuffers.empty())
+  {
+    // recorded again whenever the scene changes, don't leak the previous ones
+    device->freeCommandBuffers(commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+  }
+
   commandBuffers.resize(framebuffers.size());
 
   vk::CommandBufferAllocateInfo allocInfo = { commandPool, vk::CommandBufferLevel::ePrimary, (uint32_t)commandBuffers.size() };
@@ -129,7 +144,7 @@ void lpe::Commands::CreateCommandBuffers(const std::vector<vk::Framebuffer>& fra
     vk::RenderPassBeginInfo renderPassInfo = { renderPass, framebuffers[i], { { 0, 0 }, extent }, (uint32_t)clearValues.size(), clearValues.data() };
     commandBuffers[i].beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
 
-    if (renderer.GetVertexBuffer() && renderer.GetIndexBuffer())
+    if (!renderer.Empty() && renderer.GetIndirectBuffer())
     {
       vk::Viewport viewport = { 0, 0, (float)extent.width, (float)extent.height, 0.0, 1.0f };
       commandBuffers[i].setViewport(0, 1, &viewport);
@@ -140,28 +155,48 @@ void lpe::Commands::CreateCommandBuffers(const std::vector<vk::Framebuffer>& fra
 			std::array<uint32_t, 1> dynOffsets = { 0 };
 			commandBuffers[i].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.GetPipelineLayout(), 0, 1, pipeline.GetDescriptorSetRef(), dynOffsets.size(), dynOffsets.data());
 
-      commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.GetPipeline());
-
-			VkDeviceSize offsets[1] = { 0 };
-			vk::Buffer vertexBuffer = renderer.GetVertexBuffer();
-			vk::Buffer instanceBuffer = ubo.GetInstanceBuffer();
-      commandBuffers[i].bindVertexBuffers(0, 1, &vertexBuffer, offsets);
-			commandBuffers[i].bindVertexBuffers(1, 1, &instanceBuffer, offsets);
-      commandBuffers[i].bindIndexBuffer(renderer.GetIndexBuffer(), 0, vk::IndexType::eUint32);
-
-			if (physicalDevice.getFeatures().multiDrawIndirect)
-			{
-				commandBuffers[i].drawIndexedIndirect(renderer.GetIndirectBuffer(), 0, renderer.GetCount(), sizeof(vk::DrawIndexedIndirectCommand));
-			}
-			else
-			{
-				auto cmds = renderer.GetDrawIndexedIndirectCommands();
-
-				for (auto j = 0; j < cmds.size(); j++)
-				{
-					commandBuffers[i].drawIndexedIndirect(renderer.GetIndirectBuffer(), j * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
-				}
-			}
+			VkDeviceSize offsets[2] = { 0, 0 };
+			std::array<vk::Buffer, 2> instanceBuffers = { ubo.GetInstanceBuffer(), ubo.GetAnimationBuffer() };
+			commandBuffers[i].bindVertexBuffers(1, (uint32_t)instanceBuffers.size(), instanceBuffers.data(), offsets);
+
+      // the pipelines share their layout, the descriptor set and the instance buffers stay bound between them
+      for (uint32_t vertexFormat = 0; vertexFormat < VertexFormatCount; vertexFormat++)
+      {
+        vk::Buffer vertexBuffer = renderer.GetVertexBuffer((VertexFormat)vertexFormat);
+        bool pipelineBound = false;
+
+        for (uint32_t indexFormat = 0; indexFormat < IndexFormatCount; indexFormat++)
+        {
+          const auto group = renderer.GetDrawGroup((VertexFormat)vertexFormat, (IndexFormat)indexFormat);
+          vk::Buffer indexBuffer = renderer.GetIndexBuffer((IndexFormat)indexFormat);
+
+          if (group.commandCount == 0 || !vertexBuffer || !indexBuffer)
+          {
+            continue;
+          }
+
+          if (!pipelineBound)
+          {
+            commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.GetPipeline((VertexFormat)vertexFormat));
+            commandBuffers[i].bindVertexBuffers(0, 1, &vertexBuffer, offsets);
+            pipelineBound = true;
+          }
+
+          commandBuffers[i].bindIndexBuffer(indexBuffer, 0, (IndexFormat)indexFormat == IndexFormat::Uint16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32);
+
+          if (physicalDevice.getFeatures().multiDrawIndirect)
+          {
+            commandBuffers[i].drawIndexedIndirect(renderer.GetIndirectBuffer(), group.firstCommand * sizeof(vk::DrawIndexedIndirectCommand), group.commandCount, sizeof(vk::DrawIndexedIndirectCommand));
+          }
+          else
+          {
+            for (auto j = group.firstCommand; j < group.firstCommand + group.commandCount; j++)
+            {
+              commandBuffers[i].drawIndexedIndirect(renderer.GetIndirectBuffer(), j * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+            }
+          }
+        }
+      }
     }
 
     commandBuffers[i].endRenderPass();
@@ -181,12 +216,26 @@ vk::CommandBuffer lpe::Commands::BeginSingleTimeCommands() const
   return commandBuffer;
 }
 
+lpe::StagingRing& lpe::Commands::GetStagingRing() const
+{
+  return *stagingRing;
+}
+
 vk::CommandBuffer lpe::Commands::operator[](uint32_t index)
 {
   return commandBuffers[index];
 }
 
 void lpe::Commands::EndSingleTimeCommands(vk::CommandBuffer commandBuffer) const
+{
+  auto fence = SubmitSingleTimeCommands(commandBuffer);
+
+  WaitFor(fence);
+
+  FreeSingleTimeCommands(commandBuffer, fence);
+}
+
+vk::Fence lpe::Commands::SubmitSingleTimeCommands(vk::CommandBuffer commandBuffer) const
 {
   commandBuffer.end();
 
@@ -198,11 +247,34 @@ void lpe::Commands::EndSingleTimeCommands(vk::CommandBuffer commandBuffer) const
   auto result = device->createFence(&fenceCreateInfo, nullptr, &fence);
   helper::ThrowIfNotSuccess(result, "Failed to create Fence");
 
-  graphicsQueue->submit(1, &submitInfo, fence);
+  result = graphicsQueue->submit(1, &submitInfo, fence);
+  helper::ThrowIfNotSuccess(result, "Failed to submit single time commands");
+
+  return fence;
+}
+
+bool lpe::Commands::IsFinished(vk::Fence fence) const
+{
+  auto result = device->getFenceStatus(fence);
+
+  if (result == vk::Result::eNotReady)
+  {
+    return false;
+  }
 
-  result = device->waitForFences(1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+  helper::ThrowIfNotSuccess(result, "Failed to get Fence status");
+
+  return true;
+}
+
+void lpe::Commands::WaitFor(vk::Fence fence) const
+{
+  auto result = device->waitForFences(1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
   helper::ThrowIfNotSuccess(result, "Failed to wait for Fences");
+}
 
+void lpe::Commands::FreeSingleTimeCommands(vk::CommandBuffer commandBuffer, vk::Fence fence) const
+{
   device->destroyFence(fence);
 
   device->freeCommandBuffers(commandPool, 1, &commandBuffer);
@@ -210,15 +282,10 @@ void lpe::Commands::EndSingleTimeCommands(vk::CommandBuffer commandBuffer) const
 
 lpe::Buffer lpe::Commands::CreateBuffer(void* data, vk::DeviceSize size) const
 {
-  Buffer staging = {physicalDevice, device.get(), data, size};
-
   Buffer actual = { physicalDevice, device.get(), size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal };
 
-  auto commandBuffer = BeginSingleTimeCommands();
-
-  actual.Copy(staging, commandBuffer);
-
-  EndSingleTimeCommands(commandBuffer);
+  stagingRing->Upload(actual, data, size);
+  stagingRing->Flush();
 
   return actual;
 }
@@ -1,5 +1,6 @@
 #include "../include/Device.h"
 #include "../include/Instance.h"
+#include "../include/MemoryAllocator.h"
 
 lpe::Device::Device(const Device& device)
 {
@@ -108,6 +109,8 @@ lpe::Device::~Device()
 
     if (device)
     {
+      // every buffer and image was destroyed already, their memory is only held by the allocator's blocks
+      MemoryAllocator::Shared().Release(device);
       device.destroy(nullptr);
     }
 
@@ -219,9 +222,14 @@ void lpe::Device::SubmitFrame(const std::vector<vk::SwapchainKHR>& swapChains, u
   presentQueue.waitIdle();
 }
 
-lpe::UniformBuffer lpe::Device::CreateUniformBuffer(ModelsRenderer& modelsRenderer, const Camera& camera, const Commands& commands)
+lpe::UniformBuffer lpe::Device::CreateUniformBuffer(ModelsRenderer& modelsRenderer, const Camera& camera, const Commands& commands, InstanceEncoding instanceEncoding, InstanceBuilder* instanceBuilder)
 {
-  return { physicalDevice, &device, modelsRenderer, camera, commands};
+  return { physicalDevice, &device, modelsRenderer, camera, commands, instanceEncoding, instanceBuilder };
+}
+
+lpe::InstanceBuilder lpe::Device::CreateInstanceBuilder(InstanceEncoding instanceEncoding)
+{
+  return { physicalDevice, &device, pipelineCache, instanceEncoding };
 }
 
 lpe::Pipeline lpe::Device::CreatePipeline(const SwapChain& swapChain, RenderPass& renderPass, UniformBuffer* ubo)
@@ -78,12 +78,12 @@ lpe::ImageView::ImageView(vk::PhysicalDevice physicalDevice,
 
   vk::MemoryRequirements requirements = this->device->getImageMemoryRequirements(image);
 
-  vk::MemoryAllocateInfo allocInfo = { requirements.size, helper::FindMemoryTypeIndex(requirements.memoryTypeBits, properties, physicalDevice.getMemoryProperties()) };
+  // attachments are recreated with the swap chain, so they are large and short lived enough for their own memory
+  const bool attachment = (usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment)) ? true : false;
 
-  result = this->device->allocateMemory(&allocInfo, nullptr, &memory);
-  helper::ThrowIfNotSuccess(result, "Failed to allocate image memory!");
+  memory = MemoryAllocator::Shared().Allocate(physicalDevice, *this->device, requirements, properties, tiling == vk::ImageTiling::eLinear, attachment);
 
-  this->device->bindImageMemory(image, memory, 0);
+  this->device->bindImageMemory(image, memory.memory, memory.offset);
 
   vk::ImageViewCreateInfo viewCreateInfo = { {}, image, vk::ImageViewType::e2D, format, {}, { flags, 0, 1, 0, 1 } };
   result = this->device->createImageView(&viewCreateInfo, nullptr, &imageView);
@@ -104,10 +104,7 @@ lpe::ImageView::~ImageView()
       device->destroyImage(image, nullptr);
     }
 
-    if(memory)
-    {
-      device->freeMemory(memory);
-    }
+    MemoryAllocator::Shared().Free(memory);
 
     device.release();
   }
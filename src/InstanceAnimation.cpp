@@ -0,0 +1,24 @@
+#include "../include/InstanceAnimation.h"
+
+lpe::AnimationData lpe::EncodeAnimation(const InstanceAnimation& animation, glm::vec3 pivot)
+{
+  const float length = glm::length(animation.axis);
+  const glm::vec3 axis = length > 0.0f ? animation.axis / length : glm::vec3(0, 0, 1);
+
+  return { glm::vec4(pivot, (float)animation.type), glm::vec4(axis, animation.speed), glm::vec4(animation.phase, animation.amplitude, 0.0f, 0.0f) };
+}
+
+vk::VertexInputBindingDescription lpe::GetAnimationBindingDescription()
+{
+  return { 2, sizeof(AnimationData), vk::VertexInputRate::eInstance };
+}
+
+std::vector<vk::VertexInputAttributeDescription> lpe::GetAnimationAttributeDescriptions()
+{
+  return
+  {
+    { 7, 2, vk::Format::eR32G32B32A32Sfloat, offsetof(AnimationData, pivotType) },
+    { 8, 2, vk::Format::eR32G32B32A32Sfloat, offsetof(AnimationData, axisSpeed) },
+    { 9, 2, vk::Format::eR32G32B32A32Sfloat, offsetof(AnimationData, phaseAmplitude) }
+  };
+}
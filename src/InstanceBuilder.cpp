@@ -0,0 +1,217 @@
+#include "../include/InstanceBuilder.h"
+
+namespace
+{
+  // local_size_x of shaders/instances.comp
+  const uint32_t GroupSize = 64;
+
+  // more ranges than this are built with a single dispatch from the first to the last one
+  const size_t MaxDispatches = 16;
+}
+
+void lpe::InstanceBuilder::CreateDescriptorPool()
+{
+  std::vector<vk::DescriptorPoolSize> poolSizes =
+  {
+    {vk::DescriptorType::eStorageBuffer, 2}
+  };
+
+  vk::DescriptorPoolCreateInfo poolInfo = { {}, 1, (uint32_t)poolSizes.size(), poolSizes.data() };
+
+  auto result = device->createDescriptorPool(&poolInfo, nullptr, &descriptorPool);
+  helper::ThrowIfNotSuccess(result, "Failed to create DescriptorPool!");
+}
+
+void lpe::InstanceBuilder::CreateDescriptorSetLayout()
+{
+  std::vector<vk::DescriptorSetLayoutBinding> bindings =
+  {
+    { 0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute },   // encoded instances
+    { 1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute }    // matrices
+  };
+
+  vk::DescriptorSetLayoutCreateInfo layoutInfo = { {}, (uint32_t)bindings.size(), bindings.data() };
+
+  auto result = device->createDescriptorSetLayout(&layoutInfo, nullptr, &descriptorSetLayout);
+  helper::ThrowIfNotSuccess(result, "Failed to create DescriptorSetLayout!");
+}
+
+void lpe::InstanceBuilder::CreatePipeline()
+{
+  auto shaderCode = lpe::helper::ReadSPIRVFile("shaders/instances.comp.spv");
+
+  vk::ShaderModuleCreateInfo moduleInfo = { {}, shaderCode.size(), reinterpret_cast<const uint32_t*>(shaderCode.data()) };
+  vk::ShaderModule shaderModule;
+
+  auto result = device->createShaderModule(&moduleInfo, nullptr, &shaderModule);
+  helper::ThrowIfNotSuccess(result, "Failed to create ShaderModule!");
+
+  // the range of instances, see InstanceRange
+  vk::PushConstantRange pushConstantRange = { vk::ShaderStageFlagBits::eCompute, 0, sizeof(InstanceRange) };
+
+  vk::PipelineLayoutCreateInfo pipelineLayoutInfo = { {}, 1, &descriptorSetLayout, 1, &pushConstantRange };
+
+  result = device->createPipelineLayout(&pipelineLayoutInfo, nullptr, &pipelineLayout);
+  helper::ThrowIfNotSuccess(result, "Failed to create PipelineLayout!");
+
+  // same constant as the vertex shaders, see shaders/instance.glsl
+  vk::SpecializationMapEntry instanceEncodingEntry = { 1, 0, sizeof(uint32_t) };
+  vk::SpecializationInfo specialization = { 1, &instanceEncodingEntry, sizeof(uint32_t), &encoding };
+
+  vk::PipelineShaderStageCreateInfo shaderStageInfo = { {}, vk::ShaderStageFlagBits::eCompute, shaderModule, "main", &specialization };
+
+  vk::ComputePipelineCreateInfo pipelineInfo = { {}, shaderStageInfo, pipelineLayout };
+
+  pipeline = device->createComputePipeline(cache, pipelineInfo);
+
+  device->destroyShaderModule(shaderModule);
+}
+
+void lpe::InstanceBuilder::Copy(const InstanceBuilder& other)
+{
+  this->physicalDevice = other.physicalDevice;
+  this->device.reset(other.device.get());
+
+  this->cache = other.cache;
+  this->encoding = other.encoding;
+  this->descriptorSetLayout = other.descriptorSetLayout;
+  this->pipelineLayout = other.pipelineLayout;
+  this->pipeline = other.pipeline;
+  this->descriptorPool = other.descriptorPool;
+  this->descriptorSet = other.descriptorSet;
+}
+
+void lpe::InstanceBuilder::Move(InstanceBuilder& other)
+{
+  Copy(other);
+  other.device.release();
+}
+
+lpe::InstanceBuilder::InstanceBuilder(const InstanceBuilder& other)
+{
+  Copy(other);
+}
+
+lpe::InstanceBuilder::InstanceBuilder(InstanceBuilder&& other) noexcept
+{
+  Move(other);
+}
+
+lpe::InstanceBuilder& lpe::InstanceBuilder::operator=(const InstanceBuilder& other)
+{
+  Copy(other);
+  return *this;
+}
+
+lpe::InstanceBuilder& lpe::InstanceBuilder::operator=(InstanceBuilder&& other) noexcept
+{
+  Move(other);
+  return *this;
+}
+
+lpe::InstanceBuilder::InstanceBuilder(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::PipelineCache cache, InstanceEncoding encoding)
+  : physicalDevice(physicalDevice),
+    cache(cache),
+    encoding(encoding)
+{
+  this->device.reset(device);
+
+  CreateDescriptorSetLayout();
+  CreatePipeline();
+  CreateDescriptorPool();
+}
+
+lpe::InstanceBuilder::~InstanceBuilder()
+{
+  if(device)
+  {
+    if(descriptorSetLayout)
+    {
+      device->destroyDescriptorSetLayout(descriptorSetLayout);
+    }
+
+    if(pipelineLayout)
+    {
+      device->destroyPipelineLayout(pipelineLayout);
+    }
+
+    if(pipeline)
+    {
+      device->destroyPipeline(pipeline);
+    }
+
+    if(descriptorPool)
+    {
+      device->destroyDescriptorPool(descriptorPool);
+    }
+
+    device.release();
+  }
+}
+
+void lpe::InstanceBuilder::UpdateDescriptorSets(vk::DescriptorBufferInfo parameters, vk::DescriptorBufferInfo matrices)
+{
+  if (!descriptorSet)
+  {
+    vk::DescriptorSetAllocateInfo allocInfo = { descriptorPool, 1, &descriptorSetLayout };
+
+    auto result = device->allocateDescriptorSets(&allocInfo, &descriptorSet);
+    helper::ThrowIfNotSuccess(result, "Failed to allocate DescriptorSets!");
+  }
+
+  vk::WriteDescriptorSet parametersWriteDescriptorSet = { descriptorSet };
+  parametersWriteDescriptorSet.dstBinding = 0;
+  parametersWriteDescriptorSet.descriptorCount = 1;
+  parametersWriteDescriptorSet.descriptorType = vk::DescriptorType::eStorageBuffer;
+  parametersWriteDescriptorSet.pBufferInfo = &parameters;
+
+  vk::WriteDescriptorSet matricesWriteDescriptorSet = { descriptorSet };
+  matricesWriteDescriptorSet.dstBinding = 1;
+  matricesWriteDescriptorSet.descriptorCount = 1;
+  matricesWriteDescriptorSet.descriptorType = vk::DescriptorType::eStorageBuffer;
+  matricesWriteDescriptorSet.pBufferInfo = &matrices;
+
+  std::vector<vk::WriteDescriptorSet> descriptorWrites = { parametersWriteDescriptorSet, matricesWriteDescriptorSet };
+
+  device->updateDescriptorSets((uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+}
+
+void lpe::InstanceBuilder::Build(vk::CommandBuffer commandBuffer, const std::vector<InstanceRange>& ranges) const
+{
+  if (ranges.empty())
+  {
+    return;
+  }
+
+  vk::MemoryBarrier uploaded = { vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead };
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, 1, &uploaded, 0, nullptr, 0, nullptr);
+
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+  commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+  auto dispatch = [&](InstanceRange range)
+  {
+    commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(InstanceRange), &range);
+    commandBuffer.dispatch((range.count + GroupSize - 1) / GroupSize, 1, 1);
+  };
+
+  if (ranges.size() > MaxDispatches)
+  {
+    dispatch({ ranges.front().first, ranges.back().first + ranges.back().count - ranges.front().first });
+  }
+  else
+  {
+    for (auto range : ranges)
+    {
+      dispatch(range);
+    }
+  }
+
+  vk::MemoryBarrier built = { vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eVertexAttributeRead };
+  commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexInput, {}, 1, &built, 0, nullptr, 0, nullptr);
+}
+
+lpe::InstanceEncoding lpe::InstanceBuilder::GetEncoding() const
+{
+  return encoding;
+}
@@ -0,0 +1,58 @@
+#include "../include/InstanceCompose.h"
+#include "../include/InstanceStorage.h"
+
+// sse is part of every x86-64 target, so this needs no extra compiler flags or cpu checks
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LPE_COMPOSE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+  bool IsStreamed(const uint32_t* flags, uint32_t i)
+  {
+    return !flags || lpe::InstanceFlags::IsStreamed(flags[i]);
+  }
+
+  // the translation only adds position * w to the columns, w is 0 for all but the last column of affine transforms
+#if defined(LPE_COMPOSE_SSE)
+  void Compose(const glm::vec3& position, const glm::mat4& transform, lpe::InstanceData& instance)
+  {
+    const float* source = reinterpret_cast<const float*>(&transform);
+    float* target = reinterpret_cast<float*>(&instance);
+
+    const __m128 offset = _mm_setr_ps(position.x, position.y, position.z, 0.0f);
+
+    for (int column = 0; column < 4; ++column)
+    {
+      const __m128 value = _mm_loadu_ps(source + column * 4);
+      const __m128 w = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3));
+
+      _mm_storeu_ps(target + column * 4, _mm_add_ps(value, _mm_mul_ps(offset, w)));
+    }
+  }
+#else
+  void Compose(const glm::vec3& position, const glm::mat4& transform, lpe::InstanceData& instance)
+  {
+    instance.row1 = transform[0] + glm::vec4(position * transform[0].w, 0.0f);
+    instance.row2 = transform[1] + glm::vec4(position * transform[1].w, 0.0f);
+    instance.row3 = transform[2] + glm::vec4(position * transform[2].w, 0.0f);
+    instance.row4 = transform[3] + glm::vec4(position * transform[3].w, 0.0f);
+  }
+#endif
+}
+
+uint32_t lpe::ComposeInstances(const glm::vec3* positions, const glm::mat4* transforms, const uint32_t* flags, uint32_t count, InstanceData* instances)
+{
+  uint32_t written = 0;
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (IsStreamed(flags, i))
+    {
+      Compose(positions[i], transforms[i], instances[written++]);
+    }
+  }
+
+  return written;
+}
@@ -0,0 +1,255 @@
+#include "../include/InstanceEncoding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+  // round to nearest, values beyond the half range become infinite
+  uint16_t ToHalf(float value)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t floatExponent = (bits >> 23) & 0xff;
+    const int32_t exponent = (int32_t)floatExponent - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (floatExponent == 0xff)
+    {
+      return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+
+    if (exponent >= 31)
+    {
+      return (uint16_t)(sign | 0x7c00);
+    }
+
+    if (exponent <= 0)
+    {
+      if (exponent < -10)
+      {
+        return (uint16_t)sign;
+      }
+
+      // denormal
+      mantissa |= 0x800000;
+      const uint32_t shift = 14 - exponent;
+      uint32_t half = mantissa >> shift;
+
+      if ((mantissa >> (shift - 1)) & 1)
+      {
+        half++;
+      }
+
+      return (uint16_t)(sign | half);
+    }
+
+    // a carry out of the mantissa correctly increases the exponent
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+
+    if (mantissa & 0x1000)
+    {
+      half++;
+    }
+
+    return (uint16_t)half;
+  }
+
+  int16_t ToSnorm16(float value)
+  {
+    return (int16_t)std::round(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+  }
+
+  // splits the upper 3x3 matrix into a uniform scale and a rotation
+  void Decompose(const lpe::InstanceData& instance, float& scale, glm::vec4& rotation)
+  {
+    glm::vec3 x = glm::vec3(instance.row1);
+    glm::vec3 y = glm::vec3(instance.row2);
+    glm::vec3 z = glm::vec3(instance.row3);
+
+    scale = (glm::length(x) + glm::length(y) + glm::length(z)) / 3.0f;
+
+    // a mirroring matrix is a rotation with a negative scale
+    if (glm::dot(glm::cross(x, y), z) < 0.0f)
+    {
+      scale = -scale;
+    }
+
+    if (scale == 0.0f)
+    {
+      rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+      return;
+    }
+
+    x = glm::normalize(x / scale);
+    y = glm::normalize(y / scale);
+    z = glm::normalize(z / scale);
+
+    const float trace = x.x + y.y + z.z;
+
+    if (trace > 0.0f)
+    {
+      const float s = std::sqrt(trace + 1.0f) * 2.0f;
+      rotation = glm::vec4((y.z - z.y) / s, (z.x - x.z) / s, (x.y - y.x) / s, 0.25f * s);
+    }
+    else if (x.x > y.y && x.x > z.z)
+    {
+      const float s = std::sqrt(1.0f + x.x - y.y - z.z) * 2.0f;
+      rotation = glm::vec4(0.25f * s, (y.x + x.y) / s, (z.x + x.z) / s, (y.z - z.y) / s);
+    }
+    else if (y.y > z.z)
+    {
+      const float s = std::sqrt(1.0f + y.y - x.x - z.z) * 2.0f;
+      rotation = glm::vec4((y.x + x.y) / s, 0.25f * s, (z.y + y.z) / s, (z.x - x.z) / s);
+    }
+    else
+    {
+      const float s = std::sqrt(1.0f + z.z - x.x - y.y) * 2.0f;
+      rotation = glm::vec4((z.x + x.z) / s, (z.y + y.z) / s, 0.25f * s, (x.y - y.x) / s);
+    }
+
+    rotation = glm::normalize(rotation);
+  }
+
+  void AddAttribute(std::vector<vk::VertexInputAttributeDescription>& descriptions, vk::Format format, uint32_t offset)
+  {
+    descriptions.push_back({ 3 + (uint32_t)descriptions.size(), 1, format, offset });
+  }
+}
+
+uint32_t lpe::GetInstanceStride(InstanceEncoding encoding)
+{
+  switch (encoding)
+  {
+  case InstanceEncoding::Matrix:
+    return sizeof(InstanceData);
+  case InstanceEncoding::Affine:
+    return sizeof(AffineInstance);
+  case InstanceEncoding::PositionRotationScale:
+    return sizeof(PositionRotationScaleInstance);
+  case InstanceEncoding::QuantizedPositionRotationScale:
+    return sizeof(QuantizedInstance);
+  default:
+    throw std::runtime_error("unknown instance encoding");
+  }
+}
+
+void lpe::EncodeInstances(const std::vector<InstanceData>& instances, InstanceEncoding encoding, std::vector<uint8_t>& encoded)
+{
+  encoded.resize(instances.size() * GetInstanceStride(encoding));
+
+  EncodeInstances(instances.data(), instances.size(), encoding, encoded.data());
+}
+
+void lpe::EncodeInstances(const InstanceData* instances, size_t count, InstanceEncoding encoding, uint8_t* encoded)
+{
+  switch (encoding)
+  {
+  case InstanceEncoding::Matrix:
+    if (count > 0)
+    {
+      memcpy(encoded, instances, count * sizeof(InstanceData));
+    }
+    break;
+  case InstanceEncoding::Affine:
+  {
+    auto affine = reinterpret_cast<AffineInstance*>(encoded);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const auto& instance = instances[i];
+
+      for (int row = 0; row < 3; ++row)
+      {
+        affine[i].rows[row] = glm::vec4(instance.row1[row], instance.row2[row], instance.row3[row], instance.row4[row]);
+      }
+    }
+    break;
+  }
+  case InstanceEncoding::PositionRotationScale:
+  {
+    auto prs = reinterpret_cast<PositionRotationScaleInstance*>(encoded);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      float scale;
+      Decompose(instances[i], scale, prs[i].rotation);
+      prs[i].positionScale = glm::vec4(glm::vec3(instances[i].row4), scale);
+    }
+    break;
+  }
+  case InstanceEncoding::QuantizedPositionRotationScale:
+  {
+    auto quantized = reinterpret_cast<QuantizedInstance*>(encoded);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      float scale;
+      glm::vec4 rotation;
+      Decompose(instances[i], scale, rotation);
+
+      for (int component = 0; component < 3; ++component)
+      {
+        quantized[i].positionScale[component] = ToHalf(instances[i].row4[component]);
+      }
+
+      quantized[i].positionScale[3] = ToHalf(scale);
+
+      for (int component = 0; component < 4; ++component)
+      {
+        quantized[i].rotation[component] = ToSnorm16(rotation[component]);
+      }
+    }
+    break;
+  }
+  default:
+    throw std::runtime_error("unknown instance encoding");
+  }
+}
+
+vk::VertexInputBindingDescription lpe::GetInstanceBindingDescription(InstanceEncoding encoding)
+{
+  return { 1, GetInstanceStride(encoding), vk::VertexInputRate::eInstance };
+}
+
+std::vector<vk::VertexInputAttributeDescription> lpe::GetInstanceAttributeDescriptions(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputAttributeDescription> descriptions;
+  vk::Format format = vk::Format::eR32G32B32A32Sfloat;
+
+  switch (encoding)
+  {
+  case InstanceEncoding::Matrix:
+    AddAttribute(descriptions, format, offsetof(InstanceData, row1));
+    AddAttribute(descriptions, format, offsetof(InstanceData, row2));
+    AddAttribute(descriptions, format, offsetof(InstanceData, row3));
+    AddAttribute(descriptions, format, offsetof(InstanceData, row4));
+    break;
+  case InstanceEncoding::Affine:
+    AddAttribute(descriptions, format, offsetof(AffineInstance, rows[0]));
+    AddAttribute(descriptions, format, offsetof(AffineInstance, rows[1]));
+    AddAttribute(descriptions, format, offsetof(AffineInstance, rows[2]));
+    break;
+  case InstanceEncoding::PositionRotationScale:
+    AddAttribute(descriptions, format, offsetof(PositionRotationScaleInstance, positionScale));
+    AddAttribute(descriptions, format, offsetof(PositionRotationScaleInstance, rotation));
+    break;
+  case InstanceEncoding::QuantizedPositionRotationScale:
+    format = vk::Format::eR16G16B16A16Sfloat;
+    AddAttribute(descriptions, format, offsetof(QuantizedInstance, positionScale));
+    AddAttribute(descriptions, vk::Format::eR16G16B16A16Snorm, offsetof(QuantizedInstance, rotation));
+    break;
+  default:
+    throw std::runtime_error("unknown instance encoding");
+  }
+
+  // the locations the encoding doesn't need read its first attribute again, the shader ignores them
+  while (descriptions.size() < 4)
+  {
+    AddAttribute(descriptions, format, 0);
+  }
+
+  return descriptions;
+}
@@ -0,0 +1,344 @@
+#include "../include/InstanceStorage.h"
+#include "../include/InstanceCompose.h"
+#include <algorithm>
+
+uint32_t lpe::InstanceStorage::GetDense(InstanceHandle handle) const
+{
+  if (!IsValid(handle))
+  {
+    throw std::runtime_error("Invalid instance handle!");
+  }
+
+  return slots[handle.slot].dense;
+}
+
+void lpe::InstanceStorage::CheckRange(uint32_t first, uint32_t count) const
+{
+  if ((uint64_t)first + count > positions.size())
+  {
+    throw std::runtime_error("Instance range exceeds the instance count!");
+  }
+}
+
+lpe::InstanceHandle lpe::InstanceStorage::Add()
+{
+  uint32_t slot;
+
+  if (freeSlots.empty())
+  {
+    slot = (uint32_t)slots.size();
+    slots.push_back({ 0, 0 });
+  }
+  else
+  {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  }
+
+  slots[slot].dense = (uint32_t)positions.size();
+
+  positions.push_back(glm::vec3(0.0f));
+  transforms.push_back(glm::mat4(1.0f));
+  flags.push_back(InstanceFlags::Visible);
+  animations.push_back({});
+  slotOfDense.push_back(slot);
+
+  streamedCount++;
+  version++;
+
+  return { slot, slots[slot].generation };
+}
+
+void lpe::InstanceStorage::Add(uint32_t count, std::vector<InstanceHandle>& handles)
+{
+  positions.reserve(positions.size() + count);
+  transforms.reserve(transforms.size() + count);
+  flags.reserve(flags.size() + count);
+  animations.reserve(animations.size() + count);
+  slotOfDense.reserve(slotOfDense.size() + count);
+  handles.reserve(handles.size() + count);
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    handles.push_back(Add());
+  }
+}
+
+void lpe::InstanceStorage::Remove(InstanceHandle handle)
+{
+  if (!IsValid(handle))
+  {
+    return;
+  }
+
+  const uint32_t dense = slots[handle.slot].dense;
+  const uint32_t last = (uint32_t)positions.size() - 1;
+
+  if (InstanceFlags::IsStreamed(flags[dense]))
+  {
+    streamedCount--;
+  }
+
+  // the last instance fills the hole, only its slot has to follow
+  positions[dense] = positions[last];
+  transforms[dense] = transforms[last];
+  flags[dense] = flags[last];
+  animations[dense] = animations[last];
+  slotOfDense[dense] = slotOfDense[last];
+  slots[slotOfDense[dense]].dense = dense;
+
+  positions.pop_back();
+  transforms.pop_back();
+  flags.pop_back();
+  animations.pop_back();
+  slotOfDense.pop_back();
+
+  slots[handle.slot].generation++;
+  freeSlots.push_back(handle.slot);
+  version++;
+}
+
+bool lpe::InstanceStorage::IsValid(InstanceHandle handle) const
+{
+  // removing an instance bumps the generation of its slot, so stale handles never match again
+  return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation;
+}
+
+void lpe::InstanceStorage::Clear()
+{
+  for (auto slot : slotOfDense)
+  {
+    slots[slot].generation++;
+    freeSlots.push_back(slot);
+  }
+
+  positions.clear();
+  transforms.clear();
+  flags.clear();
+  animations.clear();
+  slotOfDense.clear();
+  streamedCount = 0;
+  version++;
+}
+
+void lpe::InstanceStorage::SetPosition(InstanceHandle handle, glm::vec3 position)
+{
+  positions[GetDense(handle)] = position;
+  version++;
+}
+
+void lpe::InstanceStorage::Move(InstanceHandle handle, glm::vec3 delta)
+{
+  positions[GetDense(handle)] += delta;
+  version++;
+}
+
+glm::vec3 lpe::InstanceStorage::GetPosition(InstanceHandle handle) const
+{
+  return positions[GetDense(handle)];
+}
+
+void lpe::InstanceStorage::SetTransform(InstanceHandle handle, glm::mat4 transform)
+{
+  transforms[GetDense(handle)] = transform;
+  version++;
+}
+
+glm::mat4 lpe::InstanceStorage::Transform(InstanceHandle handle, glm::mat4 transform)
+{
+  auto& matrix = transforms[GetDense(handle)];
+  matrix = matrix * transform;
+  version++;
+
+  return matrix;
+}
+
+glm::mat4 lpe::InstanceStorage::GetTransform(InstanceHandle handle) const
+{
+  return transforms[GetDense(handle)];
+}
+
+void lpe::InstanceStorage::SetVisible(InstanceHandle handle, bool visible)
+{
+  auto& flag = flags[GetDense(handle)];
+  const bool wasVisible = (flag & InstanceFlags::Visible) != 0;
+
+  if (visible == wasVisible)
+  {
+    return;
+  }
+
+  flag ^= InstanceFlags::Visible;
+  version++;
+
+  if (flag & InstanceFlags::Baked)
+  {
+    return;
+  }
+
+  if (visible)
+  {
+    streamedCount++;
+  }
+  else
+  {
+    streamedCount--;
+  }
+}
+
+void lpe::InstanceStorage::SetAnimation(InstanceHandle handle, const InstanceAnimation& animation)
+{
+  animations[GetDense(handle)] = animation;
+  version++;
+}
+
+lpe::InstanceAnimation lpe::InstanceStorage::GetAnimation(InstanceHandle handle) const
+{
+  return animations[GetDense(handle)];
+}
+
+bool lpe::InstanceStorage::IsVisible(InstanceHandle handle) const
+{
+  return (flags[GetDense(handle)] & InstanceFlags::Visible) != 0;
+}
+
+void lpe::InstanceStorage::SetStatic(InstanceHandle handle, bool isStatic)
+{
+  auto& flag = flags[GetDense(handle)];
+
+  if (isStatic)
+  {
+    flag |= InstanceFlags::Static;
+  }
+  else
+  {
+    flag &= ~InstanceFlags::Static;
+  }
+}
+
+bool lpe::InstanceStorage::IsStatic(InstanceHandle handle) const
+{
+  return (flags[GetDense(handle)] & InstanceFlags::Static) != 0;
+}
+
+bool lpe::InstanceStorage::IsBaked(InstanceHandle handle) const
+{
+  return (flags[GetDense(handle)] & InstanceFlags::Baked) != 0;
+}
+
+uint32_t lpe::InstanceStorage::GetIndex(InstanceHandle handle) const
+{
+  return GetDense(handle);
+}
+
+lpe::InstanceHandle lpe::InstanceStorage::GetHandle(uint32_t index) const
+{
+  CheckRange(index, 1);
+
+  const uint32_t slot = slotOfDense[index];
+
+  return { slot, slots[slot].generation };
+}
+
+void lpe::InstanceStorage::SetPositions(uint32_t first, const glm::vec3* positions, uint32_t count)
+{
+  CheckRange(first, count);
+
+  std::copy(positions, positions + count, this->positions.begin() + first);
+  version++;
+}
+
+void lpe::InstanceStorage::SetTransforms(uint32_t first, const glm::mat4* transforms, uint32_t count)
+{
+  CheckRange(first, count);
+
+  std::copy(transforms, transforms + count, this->transforms.begin() + first);
+  version++;
+}
+
+void lpe::InstanceStorage::SetPositions(const std::vector<InstanceHandle>& handles, const glm::vec3* positions)
+{
+  for (size_t i = 0; i < handles.size(); ++i)
+  {
+    this->positions[GetDense(handles[i])] = positions[i];
+  }
+
+  version++;
+}
+
+void lpe::InstanceStorage::SetTransforms(const std::vector<InstanceHandle>& handles, const glm::mat4* transforms)
+{
+  for (size_t i = 0; i < handles.size(); ++i)
+  {
+    this->transforms[GetDense(handles[i])] = transforms[i];
+  }
+
+  version++;
+}
+
+glm::vec3* lpe::InstanceStorage::MapPositions()
+{
+  version++;
+
+  return positions.data();
+}
+
+glm::mat4* lpe::InstanceStorage::MapTransforms()
+{
+  version++;
+
+  return transforms.data();
+}
+
+uint32_t lpe::InstanceStorage::GetCount() const
+{
+  return (uint32_t)positions.size();
+}
+
+uint32_t lpe::InstanceStorage::GetStreamedCount() const
+{
+  return streamedCount;
+}
+
+uint32_t lpe::InstanceStorage::GetVersion() const
+{
+  return version;
+}
+
+void lpe::InstanceStorage::Pack(std::vector<InstanceData>& instances, std::vector<AnimationData>& animations) const
+{
+  const size_t first = instances.size();
+  instances.resize(first + streamedCount);
+
+  ComposeInstances(positions.data(), transforms.data(), flags.data(), (uint32_t)positions.size(), instances.data() + first);
+
+  // the animations pivot around the composed translation
+  animations.reserve(animations.size() + streamedCount);
+
+  size_t instance = first;
+  for (size_t i = 0; i < positions.size(); ++i)
+  {
+    if (InstanceFlags::IsStreamed(flags[i]))
+    {
+      animations.push_back(EncodeAnimation(this->animations[i], glm::vec3(instances[instance++].row4)));
+    }
+  }
+}
+
+void lpe::InstanceStorage::Bake(std::vector<InstanceData>& instances)
+{
+  const uint32_t bakeable = InstanceFlags::Visible | InstanceFlags::Static;
+
+  for (size_t i = 0; i < positions.size(); ++i)
+  {
+    if ((flags[i] & (bakeable | InstanceFlags::Baked)) == bakeable)
+    {
+      instances.emplace_back();
+      ComposeInstances(&positions[i], &transforms[i], nullptr, 1, &instances.back());
+
+      flags[i] |= InstanceFlags::Baked;
+      streamedCount--;
+      version++;
+    }
+  }
+}
@@ -0,0 +1,144 @@
+#include "../include/MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+lpe::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  data = other.data;
+  size = other.size;
+
+  other.data = nullptr;
+  other.size = 0;
+}
+
+lpe::MappedFile& lpe::MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    Close();
+
+    data = other.data;
+    size = other.size;
+
+    other.data = nullptr;
+    other.size = 0;
+  }
+
+  return *this;
+}
+
+lpe::MappedFile::MappedFile(const std::string& fileName)
+{
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error("Failed to open file " + fileName);
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    CloseHandle(file);
+    throw std::runtime_error("Failed to get size of file " + fileName);
+  }
+
+  size = (size_t)fileSize.QuadPart;
+
+  if (size > 0)
+  {
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping)
+    {
+      data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+      // the view keeps the mapping alive
+      CloseHandle(mapping);
+    }
+  }
+
+  CloseHandle(file);
+#else
+  int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+
+  if (fileDescriptor < 0)
+  {
+    throw std::runtime_error("Failed to open file " + fileName);
+  }
+
+  struct stat info;
+  if (fstat(fileDescriptor, &info) != 0)
+  {
+    close(fileDescriptor);
+    throw std::runtime_error("Failed to get size of file " + fileName);
+  }
+
+  size = (size_t)info.st_size;
+
+  if (size > 0)
+  {
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+    if (view != MAP_FAILED)
+    {
+      data = static_cast<const char*>(view);
+      madvise(view, size, MADV_SEQUENTIAL);
+    }
+  }
+
+  // the mapping keeps its own reference to the file
+  close(fileDescriptor);
+#endif
+
+  if (size > 0 && !data)
+  {
+    size = 0;
+    throw std::runtime_error("Failed to map file " + fileName);
+  }
+}
+
+lpe::MappedFile::~MappedFile()
+{
+  Close();
+}
+
+void lpe::MappedFile::Close()
+{
+  if (data)
+  {
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<char*>(data), size);
+#endif
+  }
+
+  data = nullptr;
+  size = 0;
+}
+
+const char* lpe::MappedFile::GetData() const
+{
+  return data;
+}
+
+size_t lpe::MappedFile::GetSize() const
+{
+  return size;
+}
+
+bool lpe::MappedFile::Empty() const
+{
+  return size == 0;
+}
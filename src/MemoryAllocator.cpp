@@ -0,0 +1,344 @@
+#include "../include/MemoryAllocator.h"
+#include <algorithm>
+
+const vk::DeviceSize lpe::MemoryAllocator::MinSize;
+const vk::DeviceSize lpe::MemoryAllocator::DefaultBlockSize;
+
+void lpe::MemoryAllocator::Bind(vk::PhysicalDevice physicalDevice, vk::Device device)
+{
+  if (this->device)
+  {
+    if (this->device != device)
+    {
+      throw std::runtime_error("MemoryAllocator is bound to another device!");
+    }
+
+    return;
+  }
+
+  this->physicalDevice = physicalDevice;
+  this->device = device;
+
+  memoryProperties = physicalDevice.getMemoryProperties();
+  bufferImageGranularity = physicalDevice.getProperties().limits.bufferImageGranularity;
+}
+
+vk::DeviceSize lpe::MemoryAllocator::GetBlockSize(uint32_t memoryType) const
+{
+  const auto heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+
+  // small heaps, like the host visible part of device memory, still fit several blocks
+  vk::DeviceSize size = DefaultBlockSize;
+  while (size > MinSize && size * 8 > heapSize)
+  {
+    size /= 2;
+  }
+
+  return size;
+}
+
+vk::DeviceMemory lpe::MemoryAllocator::AllocateMemory(vk::DeviceSize size, uint32_t memoryType, void** mapped)
+{
+  vk::MemoryAllocateInfo allocInfo = { size, memoryType };
+  vk::DeviceMemory memory;
+
+  auto result = device.allocateMemory(&allocInfo, nullptr, &memory);
+  helper::ThrowIfNotSuccess(result, "Failed to allocate device memory!");
+
+  *mapped = nullptr;
+
+  if (memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+  {
+    result = device.mapMemory(memory, 0, VK_WHOLE_SIZE, {}, mapped);
+
+    if (result != vk::Result::eSuccess)
+    {
+      device.freeMemory(memory);
+      helper::ThrowIfNotSuccess(result, "Failed to map device memory!");
+    }
+  }
+
+  return memory;
+}
+
+lpe::MemoryAllocator::Block* lpe::MemoryAllocator::CreateBlock(vk::DeviceSize size, uint32_t memoryType, bool linear)
+{
+  auto block = std::make_unique<Block>();
+  block->size = size;
+  block->memoryType = memoryType;
+  block->linear = linear;
+  block->memory = AllocateMemory(size, memoryType, &block->mapped);
+
+  uint32_t orders = 1;
+  while ((MinSize << (orders - 1)) < size)
+  {
+    orders++;
+  }
+
+  block->freeRanges.resize(orders);
+  block->freeRanges.back().insert(0);
+
+  blocks.push_back(std::move(block));
+
+  return blocks.back().get();
+}
+
+bool lpe::MemoryAllocator::Allocate(Block& block, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset)
+{
+  // ranges are aligned to their size, so rounding up to the alignment is enough
+  uint32_t order = 0;
+  while ((MinSize << order) < size || (MinSize << order) < alignment)
+  {
+    order++;
+  }
+
+  uint32_t available = order;
+  while (available < block.freeRanges.size() && block.freeRanges[available].empty())
+  {
+    available++;
+  }
+
+  if (available >= block.freeRanges.size())
+  {
+    return false;
+  }
+
+  // the lowest free range keeps the allocations packed at the start of the block
+  offset = *block.freeRanges[available].begin();
+  block.freeRanges[available].erase(block.freeRanges[available].begin());
+
+  // splitting keeps the lower half, the upper one becomes free
+  while (available > order)
+  {
+    available--;
+    block.freeRanges[available].insert(offset + (MinSize << available));
+  }
+
+  block.allocations[offset] = std::make_pair(order, size);
+
+  return true;
+}
+
+void lpe::MemoryAllocator::Free(Block& block, vk::DeviceSize offset)
+{
+  auto allocation = block.allocations.find(offset);
+
+  if (allocation == block.allocations.end())
+  {
+    return;
+  }
+
+  uint32_t order = allocation->second.first;
+  block.allocations.erase(allocation);
+
+  // merges with the buddy as long as it's free as well
+  while (order + 1 < block.freeRanges.size())
+  {
+    const vk::DeviceSize buddy = offset ^ (MinSize << order);
+    auto free = block.freeRanges[order].find(buddy);
+
+    if (free == block.freeRanges[order].end())
+    {
+      break;
+    }
+
+    block.freeRanges[order].erase(free);
+    offset = std::min(offset, buddy);
+    order++;
+  }
+
+  block.freeRanges[order].insert(offset);
+}
+
+lpe::MemoryAllocation lpe::MemoryAllocator::Allocate(vk::PhysicalDevice physicalDevice,
+                                                     vk::Device device,
+                                                     const vk::MemoryRequirements& requirements,
+                                                     vk::MemoryPropertyFlags properties,
+                                                     bool linear,
+                                                     bool dedicated)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  Bind(physicalDevice, device);
+
+  MemoryAllocation allocation;
+  allocation.memoryType = helper::FindMemoryTypeIndex(requirements.memoryTypeBits, properties, memoryProperties);
+  allocation.size = requirements.size;
+
+  const vk::DeviceSize blockSize = GetBlockSize(allocation.memoryType);
+
+  if (dedicated || requirements.size > blockSize / 2)
+  {
+    allocation.memory = AllocateMemory(requirements.size, allocation.memoryType, &allocation.mapped);
+    allocation.dedicated = true;
+
+    dedicatedAllocations.push_back(allocation);
+
+    return allocation;
+  }
+
+  // without a granularity buffers and images can share a block
+  linear = linear || bufferImageGranularity <= 1;
+
+  Block* target = nullptr;
+
+  for (auto& block : blocks)
+  {
+    if (block->memoryType == allocation.memoryType && block->linear == linear && Allocate(*block, requirements.size, requirements.alignment, allocation.offset))
+    {
+      target = block.get();
+      break;
+    }
+  }
+
+  if (!target)
+  {
+    target = CreateBlock(blockSize, allocation.memoryType, linear);
+
+    if (!Allocate(*target, requirements.size, requirements.alignment, allocation.offset))
+    {
+      throw std::runtime_error("Failed to allocate from a new memory block!");
+    }
+  }
+
+  allocation.memory = target->memory;
+  allocation.mapped = target->mapped ? static_cast<uint8_t*>(target->mapped) + allocation.offset : nullptr;
+
+  return allocation;
+}
+
+void lpe::MemoryAllocator::Free(const MemoryAllocation& allocation)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (!allocation.memory || !device)
+  {
+    return;
+  }
+
+  if (allocation.dedicated)
+  {
+    auto dedicatedAllocation = std::find_if(dedicatedAllocations.begin(), dedicatedAllocations.end(), [&allocation](const MemoryAllocation& other)
+    {
+      return other.memory == allocation.memory;
+    });
+
+    if (dedicatedAllocation != dedicatedAllocations.end())
+    {
+      device.freeMemory(allocation.memory);
+      dedicatedAllocations.erase(dedicatedAllocation);
+    }
+
+    return;
+  }
+
+  for (auto block = blocks.begin(); block != blocks.end(); ++block)
+  {
+    if ((*block)->memory != allocation.memory)
+    {
+      continue;
+    }
+
+    Free(**block, allocation.offset);
+
+    if ((*block)->allocations.empty())
+    {
+      // the last empty block of its kind is kept, so resources which are recreated every few frames don't reallocate it
+      const bool hasOther = std::any_of(blocks.begin(), blocks.end(), [&block](const std::unique_ptr<Block>& other)
+      {
+        return other != *block && other->memoryType == (*block)->memoryType && other->linear == (*block)->linear;
+      });
+
+      if (hasOther)
+      {
+        device.freeMemory((*block)->memory);
+        blocks.erase(block);
+      }
+    }
+
+    return;
+  }
+}
+
+lpe::MemoryStats lpe::MemoryAllocator::GetStats()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  MemoryStats stats;
+
+  for (const auto& block : blocks)
+  {
+    stats.blockCount++;
+    stats.reservedSize += block->size;
+    stats.allocationCount += (uint32_t)block->allocations.size();
+
+    for (const auto& allocation : block->allocations)
+    {
+      stats.usedSize += MinSize << allocation.second.first;
+      stats.requestedSize += allocation.second.second;
+    }
+
+    for (uint32_t order = 0; order < block->freeRanges.size(); ++order)
+    {
+      const vk::DeviceSize rangeSize = MinSize << order;
+
+      stats.freeSize += rangeSize * block->freeRanges[order].size();
+      stats.freeRangeCount += (uint32_t)block->freeRanges[order].size();
+
+      if (!block->freeRanges[order].empty())
+      {
+        stats.largestFreeRange = std::max(stats.largestFreeRange, rangeSize);
+      }
+    }
+  }
+
+  for (const auto& allocation : dedicatedAllocations)
+  {
+    stats.dedicatedCount++;
+    stats.allocationCount++;
+    stats.reservedSize += allocation.size;
+    stats.usedSize += allocation.size;
+    stats.requestedSize += allocation.size;
+  }
+
+  if (stats.freeSize > 0)
+  {
+    stats.fragmentation = 1.0f - (float)stats.largestFreeRange / (float)stats.freeSize;
+  }
+
+  return stats;
+}
+
+void lpe::MemoryAllocator::Release(vk::Device device)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (!this->device || this->device != device)
+  {
+    return;
+  }
+
+  // freeing memory unmaps it as well
+  for (const auto& block : blocks)
+  {
+    device.freeMemory(block->memory);
+  }
+
+  for (const auto& allocation : dedicatedAllocations)
+  {
+    device.freeMemory(allocation.memory);
+  }
+
+  blocks.clear();
+  dedicatedAllocations.clear();
+
+  this->device = nullptr;
+  this->physicalDevice = nullptr;
+}
+
+lpe::MemoryAllocator& lpe::MemoryAllocator::Shared()
+{
+  static MemoryAllocator allocator;
+
+  return allocator;
+}
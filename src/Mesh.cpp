@@ -0,0 +1,231 @@
+#include "../include/Mesh.h"
+#include "../include/Palette.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+  // FNV-1a
+  void HashBytes(uint64_t& hash, const void* data, size_t size)
+  {
+    auto bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < size; i++)
+    {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+  }
+
+  template <typename T>
+  void HashValue(uint64_t& hash, T value)
+  {
+    HashBytes(hash, &value, sizeof(value));
+  }
+}
+
+uint64_t lpe::MeshOptions::GetKey() const
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  HashValue(hash, (uint8_t)weld);
+  HashValue(hash, weld ? weldEpsilon : 0.0f);
+  HashValue(hash, (uint8_t)optimizeVertexCache);
+  HashValue(hash, (uint8_t)optimizeOverdraw);
+  HashValue(hash, (uint8_t)optimizeVertexFetch);
+  HashValue(hash, std::max(lodCount, 1u));
+  HashValue(hash, lodCount > 1 ? lodReduction : 0.0f);
+  HashValue(hash, (uint8_t)buildMeshlets);
+  HashValue(hash, (uint32_t)vertexFormat);
+  // decides whether a palette mesh falls back to Flat, see Mesh::Pack
+  HashValue(hash, vertexFormat == VertexFormat::Palette ? Palette::MaxColors : 0u);
+
+  return hash;
+}
+
+void lpe::Mesh::ComputeBounds()
+{
+  if (vertices.empty())
+  {
+    center = glm::vec3(0.0f);
+    radius = 0.0f;
+    return;
+  }
+
+  glm::vec3 min = vertices[0].position;
+  glm::vec3 max = vertices[0].position;
+
+  for (const auto& vertex : vertices)
+  {
+    min = glm::min(min, vertex.position);
+    max = glm::max(max, vertex.position);
+  }
+
+  center = (min + max) * 0.5f;
+  radius = 0.0f;
+
+  for (const auto& vertex : vertices)
+  {
+    radius = std::max(radius, glm::distance(center, vertex.position));
+  }
+}
+
+void lpe::Mesh::Pack(VertexFormat format)
+{
+  packedVertices.clear();
+  flatVertices.clear();
+  paletteVertices.clear();
+  palette.clear();
+
+  switch (format)
+  {
+  case VertexFormat::Float:
+    return;
+  case VertexFormat::Packed:
+    packedVertices.reserve(vertices.size());
+
+    for (const auto& vertex : vertices)
+    {
+      packedVertices.push_back(PackedVertex::Pack(vertex, center, radius));
+    }
+    break;
+  case VertexFormat::Flat:
+    flatVertices.reserve(vertices.size());
+
+    for (const auto& vertex : vertices)
+    {
+      flatVertices.push_back(FlatVertex::Pack(vertex, center, radius));
+    }
+    break;
+  case VertexFormat::Palette:
+  {
+    std::unordered_map<glm::vec3, uint16_t> colors;
+
+    for (const auto& vertex : vertices)
+    {
+      colors.insert(std::make_pair(vertex.color, (uint16_t)0));
+    }
+
+    // the colors wouldn't fit into the shared palette, flat vertices keep them in the vertex instead
+    if (colors.size() > Palette::MaxColors)
+    {
+      Pack(VertexFormat::Flat);
+      return;
+    }
+
+    colors.clear();
+    paletteVertices.reserve(vertices.size());
+
+    for (const auto& vertex : vertices)
+    {
+      auto color = colors.find(vertex.color);
+
+      if (color == colors.end())
+      {
+        color = colors.insert(std::make_pair(vertex.color, (uint16_t)palette.size())).first;
+        palette.push_back(vertex.color);
+      }
+
+      paletteVertices.push_back(PaletteVertex::Pack(vertex, center, radius, color->second));
+    }
+    break;
+  }
+  default:
+    throw std::runtime_error("unknown vertex format");
+  }
+
+  vertices = {};
+  this->format = format;
+}
+
+uint32_t lpe::Mesh::GetVertexCount() const
+{
+  switch (format)
+  {
+  case VertexFormat::Packed:
+    return (uint32_t)packedVertices.size();
+  case VertexFormat::Flat:
+    return (uint32_t)flatVertices.size();
+  case VertexFormat::Palette:
+    return (uint32_t)paletteVertices.size();
+  default:
+    return (uint32_t)vertices.size();
+  }
+}
+
+const void* lpe::Mesh::GetVertexData() const
+{
+  switch (format)
+  {
+  case VertexFormat::Packed:
+    return packedVertices.data();
+  case VertexFormat::Flat:
+    return flatVertices.data();
+  case VertexFormat::Palette:
+    return paletteVertices.data();
+  default:
+    return vertices.data();
+  }
+}
+
+std::vector<lpe::Vertex> lpe::Mesh::Unpack() const
+{
+  std::vector<Vertex> unpacked;
+  unpacked.reserve(GetVertexCount());
+
+  switch (format)
+  {
+  case VertexFormat::Packed:
+    for (const auto& vertex : packedVertices)
+    {
+      unpacked.push_back(vertex.Unpack(center, radius));
+    }
+    break;
+  case VertexFormat::Flat:
+    for (const auto& vertex : flatVertices)
+    {
+      unpacked.push_back(vertex.Unpack(center, radius));
+    }
+    break;
+  case VertexFormat::Palette:
+    for (const auto& vertex : paletteVertices)
+    {
+      unpacked.push_back(vertex.Unpack(center, radius, palette));
+    }
+    break;
+  default:
+    unpacked = vertices;
+    break;
+  }
+
+  return unpacked;
+}
+
+lpe::IndexFormat lpe::Mesh::GetIndexFormat() const
+{
+  // the indices are relative to the mesh's first vertex, see RenderObject::GetIndirectCommand
+  return GetVertexCount() <= std::numeric_limits<uint16_t>::max() + 1u ? IndexFormat::Uint16 : IndexFormat::Uint32;
+}
+
+uint32_t lpe::GetIndexStride(IndexFormat format)
+{
+  switch (format)
+  {
+  case IndexFormat::Uint16:
+    return sizeof(uint16_t);
+  case IndexFormat::Uint32:
+    return sizeof(uint32_t);
+  default:
+    throw std::runtime_error("unknown index format");
+  }
+}
+
+bool lpe::Meshlet::IsBackfacing(glm::vec3 eye) const
+{
+  // the view direction has to be inside of the cone mirrored to 90 degrees, widened by the bounding sphere
+  const glm::vec3 direction = center - eye;
+
+  return glm::dot(direction, coneAxis) >= coneCutoff * glm::length(direction) + radius;
+}
@@ -0,0 +1,333 @@
+#include "../include/MeshCache.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <sys/stat.h>
+
+namespace
+{
+  const char Magic[4] = { 'L', 'P', 'E', 'M' };
+  const uint64_t BlockAlignment = 16;
+
+  struct FileStamp
+  {
+    uint64_t size;
+    int64_t time;
+  };
+
+  bool GetFileStamp(const std::string& path, FileStamp& stamp)
+  {
+#if defined(_WIN32)
+    struct _stat64 info;
+    if (_stat64(path.c_str(), &info) != 0)
+    {
+      return false;
+    }
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+      return false;
+    }
+#endif
+
+    stamp.size = (uint64_t)info.st_size;
+    stamp.time = (int64_t)info.st_mtime;
+
+    return true;
+  }
+
+  // the format a mesh cooked with the requested one can be in, palette meshes with too many colors are flat
+  bool IsCookedFormat(lpe::VertexFormat requested, lpe::VertexFormat cooked)
+  {
+    return cooked == requested || (requested == lpe::VertexFormat::Palette && cooked == lpe::VertexFormat::Flat);
+  }
+
+  uint64_t AlignUp(uint64_t value)
+  {
+    return (value + BlockAlignment - 1) & ~(BlockAlignment - 1);
+  }
+
+  bool IsInside(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size)
+  {
+    return offset <= size && count <= (size - offset) / stride;
+  }
+
+  void WritePadding(std::ofstream& stream, uint64_t from, uint64_t to)
+  {
+    static const char zeros[BlockAlignment] = {};
+    stream.write(zeros, (std::streamsize)(to - from));
+  }
+
+  // pads up to offset and writes the block, position is where the stream currently is
+  void WriteBlock(std::ofstream& stream, uint64_t& position, uint64_t offset, const void* data, uint64_t size)
+  {
+    WritePadding(stream, position, offset);
+    stream.write(static_cast<const char*>(data), (std::streamsize)size);
+    position = offset + size;
+  }
+}
+
+lpe::MeshCache::MeshCache(MeshCache&& other) noexcept
+  : file(std::move(other.file)),
+    header(other.header)
+{
+  other.header = nullptr;
+}
+
+lpe::MeshCache& lpe::MeshCache::operator=(MeshCache&& other) noexcept
+{
+  file = std::move(other.file);
+  header = other.header;
+  other.header = nullptr;
+
+  return *this;
+}
+
+bool lpe::MeshCache::Open(const std::string& cachePath, const std::string& sourcePath, const MeshOptions& options)
+{
+  header = nullptr;
+
+  FileStamp source;
+  FileStamp cache;
+
+  if (!GetFileStamp(sourcePath, source) || !GetFileStamp(cachePath, cache) || cache.size < sizeof(MeshCacheHeader))
+  {
+    return false;
+  }
+
+  try
+  {
+    file = MappedFile(cachePath);
+  }
+  catch (const std::runtime_error&)
+  {
+    return false;
+  }
+
+  auto candidate = reinterpret_cast<const MeshCacheHeader*>(file.GetData());
+  const uint64_t size = file.GetSize();
+
+  if (size < sizeof(MeshCacheHeader) ||
+      memcmp(candidate->magic, Magic, sizeof(Magic)) != 0 ||
+      candidate->version != Version ||
+      candidate->vertexFormat >= VertexFormatCount ||
+      candidate->vertexStride != GetVertexStride((VertexFormat)candidate->vertexFormat) ||
+      candidate->indexStride != sizeof(uint32_t) ||
+      candidate->sourceSize != source.size ||
+      candidate->sourceTime != source.time ||
+      candidate->optionsKey != options.GetKey() ||
+      !IsCookedFormat(options.vertexFormat, (VertexFormat)candidate->vertexFormat))
+  {
+    file = MappedFile();
+    return false;
+  }
+
+  if (!IsInside(candidate->vertexOffset, candidate->vertexCount, candidate->vertexStride, size) ||
+      !IsInside(candidate->indexOffset, candidate->indexCount, sizeof(uint32_t), size) ||
+      !IsInside(candidate->lodOffset, candidate->lodCount, sizeof(MeshLod), size) ||
+      !IsInside(candidate->meshletOffset, candidate->meshletCount, sizeof(Meshlet), size) ||
+      !IsInside(candidate->meshletVertexOffset, candidate->meshletVertexCount, sizeof(uint32_t), size) ||
+      !IsInside(candidate->meshletTriangleOffset, candidate->meshletTriangleSize, 1, size) ||
+      !IsInside(candidate->paletteOffset, candidate->paletteCount, sizeof(glm::vec3), size))
+  {
+    file = MappedFile();
+    return false;
+  }
+
+  header = candidate;
+
+  return true;
+}
+
+lpe::VertexFormat lpe::MeshCache::GetVertexFormat() const
+{
+  return header ? (VertexFormat)header->vertexFormat : VertexFormat::Float;
+}
+
+const void* lpe::MeshCache::GetVertexData() const
+{
+  return header ? file.GetData() + header->vertexOffset : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetVertexCount() const
+{
+  return header ? (uint32_t)header->vertexCount : 0;
+}
+
+const uint32_t* lpe::MeshCache::GetIndices() const
+{
+  return header ? reinterpret_cast<const uint32_t*>(file.GetData() + header->indexOffset) : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetIndexCount() const
+{
+  return header ? (uint32_t)header->indexCount : 0;
+}
+
+const lpe::MeshLod* lpe::MeshCache::GetLods() const
+{
+  return header ? reinterpret_cast<const MeshLod*>(file.GetData() + header->lodOffset) : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetLodCount() const
+{
+  return header ? (uint32_t)header->lodCount : 0;
+}
+
+const lpe::Meshlet* lpe::MeshCache::GetMeshlets() const
+{
+  return header ? reinterpret_cast<const Meshlet*>(file.GetData() + header->meshletOffset) : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetMeshletCount() const
+{
+  return header ? (uint32_t)header->meshletCount : 0;
+}
+
+const uint32_t* lpe::MeshCache::GetMeshletVertices() const
+{
+  return header ? reinterpret_cast<const uint32_t*>(file.GetData() + header->meshletVertexOffset) : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetMeshletVertexCount() const
+{
+  return header ? (uint32_t)header->meshletVertexCount : 0;
+}
+
+const uint8_t* lpe::MeshCache::GetMeshletTriangles() const
+{
+  return header ? reinterpret_cast<const uint8_t*>(file.GetData() + header->meshletTriangleOffset) : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetMeshletTriangleSize() const
+{
+  return header ? (uint32_t)header->meshletTriangleSize : 0;
+}
+
+const glm::vec3* lpe::MeshCache::GetPalette() const
+{
+  return header ? reinterpret_cast<const glm::vec3*>(file.GetData() + header->paletteOffset) : nullptr;
+}
+
+uint32_t lpe::MeshCache::GetPaletteCount() const
+{
+  return header ? (uint32_t)header->paletteCount : 0;
+}
+
+lpe::MeshStats lpe::MeshCache::GetStats() const
+{
+  return header ? header->stats : MeshStats{};
+}
+
+void lpe::MeshCache::GetBounds(glm::vec3& center, float& radius) const
+{
+  center = header ? header->center : glm::vec3(0.0f);
+  radius = header ? header->radius : 0.0f;
+}
+
+std::string lpe::MeshCache::GetCachePath(const std::string& sourcePath, const MeshOptions& options)
+{
+  auto extension = sourcePath.find_last_of('.');
+  auto separator = sourcePath.find_last_of("/\\");
+
+  if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+  {
+    extension = sourcePath.size();
+  }
+
+  // one cache per set of options, so meshes loaded with different options don't overwrite each other's cache
+  char key[17];
+  snprintf(key, sizeof(key), "%016llx", (unsigned long long)options.GetKey());
+
+  return sourcePath.substr(0, extension) + "." + key + ".lpem";
+}
+
+bool lpe::MeshCache::Write(const std::string& cachePath,
+                           const std::string& sourcePath,
+                           const Mesh& mesh)
+{
+  const auto& indices = mesh.indices;
+  const auto& lods = mesh.lods;
+  const auto& meshlets = mesh.meshlets;
+  const auto& meshletVertices = mesh.meshletVertices;
+  const auto& meshletTriangles = mesh.meshletTriangles;
+  const auto& palette = mesh.palette;
+
+  FileStamp source;
+  if (!GetFileStamp(sourcePath, source))
+  {
+    return false;
+  }
+
+  MeshCacheHeader header = {};
+  memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.vertexFormat = (uint32_t)mesh.format;
+  header.vertexStride = GetVertexStride(mesh.format);
+  header.indexStride = sizeof(uint32_t);
+  header.sourceSize = source.size;
+  header.sourceTime = source.time;
+  header.optionsKey = mesh.options.GetKey();
+  header.stats = mesh.stats;
+  header.center = mesh.center;
+  header.radius = mesh.radius;
+  header.vertexCount = mesh.GetVertexCount();
+  header.indexCount = indices.size();
+  header.vertexOffset = AlignUp(sizeof(MeshCacheHeader));
+  header.indexOffset = AlignUp(header.vertexOffset + header.vertexCount * header.vertexStride);
+  header.lodCount = lods.size();
+  header.lodOffset = AlignUp(header.indexOffset + indices.size() * sizeof(uint32_t));
+  header.meshletCount = meshlets.size();
+  header.meshletOffset = AlignUp(header.lodOffset + lods.size() * sizeof(MeshLod));
+  header.meshletVertexCount = meshletVertices.size();
+  header.meshletVertexOffset = AlignUp(header.meshletOffset + meshlets.size() * sizeof(Meshlet));
+  header.meshletTriangleSize = meshletTriangles.size();
+  header.meshletTriangleOffset = AlignUp(header.meshletVertexOffset + meshletVertices.size() * sizeof(uint32_t));
+  header.paletteCount = palette.size();
+  header.paletteOffset = AlignUp(header.meshletTriangleOffset + meshletTriangles.size());
+
+  // write to a temporary file first, so a crash never leaves a truncated cache behind
+  // the name is unique, loads of the same mesh on several threads may write the cache at the same time
+  static std::atomic<uint32_t> writeCount(0);
+  const std::string temporary = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." + std::to_string(writeCount++) + ".tmp";
+
+  {
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+
+    if (!stream)
+    {
+      // e.g. read-only asset directory, the mesh simply isn't cached
+      return false;
+    }
+
+    uint64_t position = 0;
+    WriteBlock(stream, position, 0, &header, sizeof(header));
+    WriteBlock(stream, position, header.vertexOffset, mesh.GetVertexData(), header.vertexCount * header.vertexStride);
+    WriteBlock(stream, position, header.indexOffset, indices.data(), indices.size() * sizeof(uint32_t));
+    WriteBlock(stream, position, header.lodOffset, lods.data(), lods.size() * sizeof(MeshLod));
+    WriteBlock(stream, position, header.meshletOffset, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+    WriteBlock(stream, position, header.meshletVertexOffset, meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t));
+    WriteBlock(stream, position, header.meshletTriangleOffset, meshletTriangles.data(), meshletTriangles.size());
+    WriteBlock(stream, position, header.paletteOffset, palette.data(), palette.size() * sizeof(glm::vec3));
+
+    if (!stream)
+    {
+      stream.close();
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+
+  // rename doesn't replace existing files on every platform
+  std::remove(cachePath.c_str());
+
+  if (std::rename(temporary.c_str(), cachePath.c_str()) != 0)
+  {
+    std::remove(temporary.c_str());
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,401 @@
+#include "../include/MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // scoring parameters from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+  const uint32_t ScoringCacheSize = 32;
+  const uint32_t MaxValence = 32;
+  const float CacheDecayPower = 1.5f;
+  const float LastTriangleScore = 0.75f;
+  const float ValenceBoostScale = 2.0f;
+  const float ValenceBoostPower = 0.5f;
+
+  const uint32_t NoTriangle = ~0u;
+
+  class ScoreTable
+  {
+  private:
+    float cacheScores[ScoringCacheSize];
+    float valenceScores[MaxValence + 1];
+
+  public:
+    ScoreTable()
+    {
+      for (uint32_t i = 0; i < ScoringCacheSize; i++)
+      {
+        // the vertices of the last triangle get a fixed score, so it doesn't matter in which order they were added
+        cacheScores[i] = i < 3 ? LastTriangleScore : std::pow(1.0f - (i - 3) / (float)(ScoringCacheSize - 3), CacheDecayPower);
+      }
+
+      valenceScores[0] = 0.0f;
+      for (uint32_t i = 1; i <= MaxValence; i++)
+      {
+        valenceScores[i] = ValenceBoostScale * std::pow((float)i, -ValenceBoostPower);
+      }
+    }
+
+    float Get(int32_t cachePosition, uint32_t remainingTriangles) const
+    {
+      if (remainingTriangles == 0)
+      {
+        return -1.0f;
+      }
+
+      const float cacheScore = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+
+      return cacheScore + valenceScores[std::min(remainingTriangles, MaxValence)];
+    }
+  };
+
+  // fifo cache simulation, a vertex is cached as long as less than cacheSize misses happened since it was loaded
+  class FifoCache
+  {
+  private:
+    std::vector<uint32_t> timestamps;
+    uint32_t time;
+
+  public:
+    explicit FifoCache(uint32_t vertexCount)
+      : timestamps(vertexCount, 0),
+        time(lpe::MeshOptimizer::SimulatedCacheSize + 1)
+    {
+    }
+
+    // returns true on a cache miss
+    bool Access(uint32_t vertex)
+    {
+      if (time - timestamps[vertex] > lpe::MeshOptimizer::SimulatedCacheSize)
+      {
+        timestamps[vertex] = time++;
+        return true;
+      }
+
+      return false;
+    }
+  };
+
+  struct Cluster
+  {
+    uint32_t firstTriangle;
+    uint32_t triangleCount;
+    float sortKey;
+  };
+}
+
+void lpe::MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+  static const ScoreTable scores;
+
+  const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+  if (triangleCount == 0)
+  {
+    return;
+  }
+
+  // triangles using each vertex, stored as one array with an offset per vertex
+  // the first remainingTriangles[vertex] entries of each list are the triangles which weren't emitted yet
+  std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+  std::vector<uint32_t> adjacency(triangleCount * 3);
+
+  for (uint32_t i = 0; i < triangleCount * 3; i++)
+  {
+    remainingTriangles[indices[i]]++;
+  }
+
+  for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+  {
+    adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingTriangles[vertex];
+  }
+
+  {
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+    for (uint32_t i = 0; i < triangleCount * 3; i++)
+    {
+      adjacency[fill[indices[i]]++] = i / 3;
+    }
+  }
+
+  std::vector<int32_t> cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+  std::vector<float> triangleScores(triangleCount);
+  std::vector<uint8_t> emitted(triangleCount, 0);
+
+  for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+  {
+    vertexScores[vertex] = scores.Get(-1, remainingTriangles[vertex]);
+  }
+
+  uint32_t best = 0;
+  for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+  {
+    const uint32_t* corners = &indices[triangle * 3];
+    triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+
+    if (triangleScores[triangle] > triangleScores[best])
+    {
+      best = triangle;
+    }
+  }
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+
+  uint32_t cache[ScoringCacheSize + 3];
+  uint32_t cacheCount = 0;
+  uint32_t nextUnemitted = 0;
+
+  while (result.size() < triangleCount * 3)
+  {
+    if (best == NoTriangle)
+    {
+      // no triangle touches the cache anymore, continue with any triangle
+      while (emitted[nextUnemitted])
+      {
+        nextUnemitted++;
+      }
+
+      best = nextUnemitted;
+    }
+
+    const uint32_t corners[3] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+
+    result.insert(result.end(), corners, corners + 3);
+    emitted[best] = 1;
+
+    for (auto vertex : corners)
+    {
+      uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+      uint32_t& remaining = remainingTriangles[vertex];
+
+      for (uint32_t i = 0; i < remaining; i++)
+      {
+        if (triangles[i] == best)
+        {
+          std::swap(triangles[i], triangles[remaining - 1]);
+          remaining--;
+          break;
+        }
+      }
+    }
+
+    // the emitted triangle moves to the front of the lru cache
+    uint32_t newCache[ScoringCacheSize + 3];
+    uint32_t newCacheCount = 0;
+
+    for (auto vertex : corners)
+    {
+      if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+      {
+        newCache[newCacheCount++] = vertex;
+      }
+    }
+
+    for (uint32_t i = 0; i < cacheCount; i++)
+    {
+      const uint32_t vertex = cache[i];
+
+      if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+      {
+        newCache[newCacheCount++] = vertex;
+      }
+    }
+
+    for (uint32_t i = 0; i < newCacheCount; i++)
+    {
+      const uint32_t vertex = newCache[i];
+
+      // vertices beyond the cache size were just evicted
+      cachePositions[vertex] = i < ScoringCacheSize ? (int32_t)i : -1;
+      vertexScores[vertex] = scores.Get(cachePositions[vertex], remainingTriangles[vertex]);
+    }
+
+    cacheCount = std::min(newCacheCount, ScoringCacheSize);
+    std::copy(newCache, newCache + cacheCount, cache);
+
+    // only triangles of vertices whose score changed are candidates for the next step
+    best = NoTriangle;
+    float bestScore = -1.0f;
+
+    for (uint32_t i = 0; i < newCacheCount; i++)
+    {
+      const uint32_t vertex = newCache[i];
+      const uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+
+      for (uint32_t j = 0; j < remainingTriangles[vertex]; j++)
+      {
+        const uint32_t triangle = triangles[j];
+        const uint32_t* triangleCorners = &indices[triangle * 3];
+
+        const float score = vertexScores[triangleCorners[0]] + vertexScores[triangleCorners[1]] + vertexScores[triangleCorners[2]];
+        triangleScores[triangle] = score;
+
+        if (score > bestScore)
+        {
+          bestScore = score;
+          best = triangle;
+        }
+      }
+    }
+  }
+
+  indices.swap(result);
+}
+
+void lpe::MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+{
+  const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+  if (triangleCount == 0)
+  {
+    return;
+  }
+
+  // a new cluster starts wherever all three vertices miss the cache, reordering clusters costs no cache efficiency there
+  std::vector<Cluster> clusters;
+  FifoCache cache((uint32_t)vertices.size());
+
+  for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+  {
+    uint32_t misses = 0;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+      misses += cache.Access(indices[triangle * 3 + i]) ? 1 : 0;
+    }
+
+    if (clusters.empty() || misses == 3)
+    {
+      clusters.push_back({ triangle, 0, 0.0f });
+    }
+
+    clusters.back().triangleCount++;
+  }
+
+  if (clusters.size() == 1)
+  {
+    return;
+  }
+
+  std::vector<glm::vec3> clusterCenters(clusters.size(), glm::vec3(0.0f));
+  std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+  glm::vec3 meshCenter(0.0f);
+  float meshArea = 0.0f;
+
+  for (size_t i = 0; i < clusters.size(); i++)
+  {
+    float clusterArea = 0.0f;
+
+    for (uint32_t triangle = clusters[i].firstTriangle; triangle < clusters[i].firstTriangle + clusters[i].triangleCount; triangle++)
+    {
+      const auto& a = vertices[indices[triangle * 3]].position;
+      const auto& b = vertices[indices[triangle * 3 + 1]].position;
+      const auto& c = vertices[indices[triangle * 3 + 2]].position;
+
+      // the cross product is twice the area weighted normal
+      const glm::vec3 normal = glm::cross(b - a, c - a);
+      const float area = glm::length(normal);
+
+      clusterNormals[i] += normal;
+      clusterCenters[i] += (a + b + c) * (area / 3.0f);
+      clusterArea += area;
+    }
+
+    meshCenter += clusterCenters[i];
+    meshArea += clusterArea;
+
+    if (clusterArea > 0.0f)
+    {
+      clusterCenters[i] /= clusterArea;
+    }
+  }
+
+  if (meshArea > 0.0f)
+  {
+    meshCenter /= meshArea;
+  }
+
+  // clusters on the outside which face away from the center are likely to occlude the rest
+  for (size_t i = 0; i < clusters.size(); i++)
+  {
+    const float normalLength = glm::length(clusterNormals[i]);
+
+    clusters[i].sortKey = normalLength > 0.0f ? glm::dot(clusterCenters[i] - meshCenter, clusterNormals[i] / normalLength) : 0.0f;
+  }
+
+  std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+  {
+    return a.sortKey > b.sortKey;
+  });
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+
+  for (const auto& cluster : clusters)
+  {
+    result.insert(result.end(), indices.begin() + cluster.firstTriangle * 3, indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+  }
+
+  indices.swap(result);
+}
+
+uint32_t lpe::MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+  const uint32_t unused = ~0u;
+
+  std::vector<uint32_t> remap(vertices.size(), unused);
+  std::vector<Vertex> result;
+  result.reserve(vertices.size());
+
+  for (auto& index : indices)
+  {
+    if (remap[index] == unused)
+    {
+      remap[index] = (uint32_t)result.size();
+      result.push_back(vertices[index]);
+    }
+
+    index = remap[index];
+  }
+
+  result.shrink_to_fit();
+  vertices.swap(result);
+
+  return (uint32_t)vertices.size();
+}
+
+lpe::VertexCacheStats lpe::MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+  VertexCacheStats stats = {};
+
+  const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+  if (triangleCount == 0)
+  {
+    return stats;
+  }
+
+  FifoCache cache(vertexCount);
+  std::vector<uint8_t> referenced(vertexCount, 0);
+
+  uint32_t misses = 0;
+  uint32_t referencedCount = 0;
+
+  for (uint32_t i = 0; i < triangleCount * 3; i++)
+  {
+    const uint32_t vertex = indices[i];
+
+    misses += cache.Access(vertex) ? 1 : 0;
+
+    if (!referenced[vertex])
+    {
+      referenced[vertex] = 1;
+      referencedCount++;
+    }
+  }
+
+  stats.acmr = misses / (float)triangleCount;
+  stats.atvr = misses / (float)referencedCount;
+
+  return stats;
+}
@@ -0,0 +1,315 @@
+#include "../include/MeshRegistry.h"
+#include "../include/MeshCache.h"
+#include "../include/MeshOptimizer.h"
+#include "../include/MeshSimplifier.h"
+#include "../include/MeshletBuilder.h"
+#include "../include/PlyFile.h"
+#include "../include/ThreadPool.h"
+#include "../include/VertexWelder.h"
+
+namespace
+{
+  std::string GetRegistryKey(const std::string& path, const lpe::MeshOptions& options)
+  {
+    return path + '|' + std::to_string(options.GetKey());
+  }
+}
+
+lpe::MeshRegistry::~MeshRegistry()
+{
+  // loads which are still running on the pool reference this registry
+  std::vector<MeshFuture> pending;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& entry : meshes)
+    {
+      if (entry.second.pending.valid())
+      {
+        pending.push_back(entry.second.pending);
+      }
+    }
+  }
+
+  for (const auto& future : pending)
+  {
+    future.wait();
+  }
+}
+
+std::shared_ptr<const lpe::Mesh> lpe::MeshRegistry::Get(const std::string& path, const MeshOptions& options)
+{
+  const auto key = GetRegistryKey(path, options);
+  MeshFuture pending;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto entry = meshes.find(key);
+    if (entry != meshes.end())
+    {
+      auto mesh = entry->second.mesh.lock();
+      if (mesh)
+      {
+        return mesh;
+      }
+
+      pending = entry->second.pending;
+    }
+  }
+
+  if (pending.valid())
+  {
+    // already loading in the background
+    return pending.get();
+  }
+
+  // loading happens outside of the lock, so different files can be loaded at the same time
+  std::shared_ptr<const Mesh> loaded = Load(path, options);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto& entry = meshes[key];
+  auto existing = entry.mesh.lock();
+  if (existing)
+  {
+    // somebody else loaded the same file in the meantime
+    return existing;
+  }
+
+  entry.mesh = loaded;
+
+  return loaded;
+}
+
+lpe::MeshFuture lpe::MeshRegistry::GetAsync(const std::string& path, const MeshOptions& options)
+{
+  const auto key = GetRegistryKey(path, options);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto& entry = meshes[key];
+
+  auto mesh = entry.mesh.lock();
+  if (mesh)
+  {
+    std::promise<std::shared_ptr<const Mesh>> loaded;
+    loaded.set_value(mesh);
+
+    return loaded.get_future().share();
+  }
+
+  if (!entry.pending.valid())
+  {
+    entry.pending = ThreadPool::Shared().Enqueue([this, path, options, key]()
+    {
+      std::shared_ptr<const Mesh> loaded;
+
+      try
+      {
+        loaded = Load(path, options);
+      }
+      catch (...)
+      {
+        // forget the failed attempt, so the next request tries again
+        std::lock_guard<std::mutex> lock(mutex);
+        meshes[key].pending = {};
+        throw;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+
+      auto& entry = meshes[key];
+      auto existing = entry.mesh.lock();
+      if (existing)
+      {
+        // a blocking Get finished first
+        loaded = existing;
+      }
+      else
+      {
+        entry.mesh = loaded;
+      }
+
+      entry.pending = {};
+
+      return loaded;
+    }).share();
+  }
+
+  return entry.pending;
+}
+
+uint32_t lpe::MeshRegistry::GetCount()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (auto entry = meshes.begin(); entry != meshes.end();)
+  {
+    if (entry->second.mesh.expired() && !entry->second.pending.valid())
+    {
+      entry = meshes.erase(entry);
+    }
+    else
+    {
+      ++entry;
+    }
+  }
+
+  return (uint32_t)meshes.size();
+}
+
+std::shared_ptr<lpe::Mesh> lpe::MeshRegistry::Load(const std::string& path, const MeshOptions& options)
+{
+  auto mesh = std::make_shared<Mesh>();
+  mesh->path = path;
+  mesh->options = options;
+
+  const auto cachePath = MeshCache::GetCachePath(path, options);
+
+  MeshCache cache;
+  if (cache.Open(cachePath, path, options))
+  {
+    mesh->stats = cache.GetStats();
+    cache.GetBounds(mesh->center, mesh->radius);
+    mesh->format = cache.GetVertexFormat();
+
+    switch (mesh->format)
+    {
+    case VertexFormat::Packed:
+    {
+      auto vertices = static_cast<const PackedVertex*>(cache.GetVertexData());
+      mesh->packedVertices.assign(vertices, vertices + cache.GetVertexCount());
+      break;
+    }
+    case VertexFormat::Flat:
+    {
+      auto vertices = static_cast<const FlatVertex*>(cache.GetVertexData());
+      mesh->flatVertices.assign(vertices, vertices + cache.GetVertexCount());
+      break;
+    }
+    case VertexFormat::Palette:
+    {
+      auto vertices = static_cast<const PaletteVertex*>(cache.GetVertexData());
+      mesh->paletteVertices.assign(vertices, vertices + cache.GetVertexCount());
+      mesh->palette.assign(cache.GetPalette(), cache.GetPalette() + cache.GetPaletteCount());
+      break;
+    }
+    default:
+    {
+      auto vertices = static_cast<const Vertex*>(cache.GetVertexData());
+      mesh->vertices.assign(vertices, vertices + cache.GetVertexCount());
+      break;
+    }
+    }
+
+    mesh->indices.assign(cache.GetIndices(), cache.GetIndices() + cache.GetIndexCount());
+    mesh->lods.assign(cache.GetLods(), cache.GetLods() + cache.GetLodCount());
+    mesh->meshlets.assign(cache.GetMeshlets(), cache.GetMeshlets() + cache.GetMeshletCount());
+    mesh->meshletVertices.assign(cache.GetMeshletVertices(), cache.GetMeshletVertices() + cache.GetMeshletVertexCount());
+    mesh->meshletTriangles.assign(cache.GetMeshletTriangles(), cache.GetMeshletTriangles() + cache.GetMeshletTriangleSize());
+    return mesh;
+  }
+
+  PlyFile(path).Read(mesh->vertices, mesh->indices, ThreadPool::Shared());
+
+  mesh->stats.sourceVertexCount = (uint32_t)mesh->vertices.size();
+  mesh->stats.sourceIndexCount = (uint32_t)mesh->indices.size();
+
+  if (options.vertexFormat == VertexFormat::Flat || options.vertexFormat == VertexFormat::Palette)
+  {
+    // the face normals are derived while shading, see shaders/base.frag
+    for (auto& vertex : mesh->vertices)
+    {
+      vertex.normals = glm::vec3(0.0f);
+    }
+  }
+
+  if (options.weld)
+  {
+    VertexWelder(options.weldEpsilon).Weld(mesh->vertices, mesh->indices);
+  }
+
+  const auto source = MeshOptimizer::AnalyzeVertexCache(mesh->indices, (uint32_t)mesh->vertices.size());
+  mesh->stats.sourceAcmr = source.acmr;
+  mesh->stats.sourceAtvr = source.atvr;
+
+  if (options.optimizeVertexCache)
+  {
+    MeshOptimizer::OptimizeVertexCache(mesh->indices, (uint32_t)mesh->vertices.size());
+  }
+
+  if (options.optimizeOverdraw)
+  {
+    MeshOptimizer::OptimizeOverdraw(mesh->indices, mesh->vertices);
+  }
+
+  if (options.optimizeVertexFetch)
+  {
+    MeshOptimizer::OptimizeVertexFetch(mesh->vertices, mesh->indices);
+  }
+
+  const auto optimized = MeshOptimizer::AnalyzeVertexCache(mesh->indices, (uint32_t)mesh->vertices.size());
+  mesh->stats.acmr = optimized.acmr;
+  mesh->stats.atvr = optimized.atvr;
+
+  mesh->ComputeBounds();
+  GenerateLods(*mesh, options);
+
+  if (options.buildMeshlets)
+  {
+    MeshletBuilder::Build(*mesh);
+  }
+
+  if (options.vertexFormat != VertexFormat::Float)
+  {
+    mesh->Pack(options.vertexFormat);
+  }
+
+  MeshCache::Write(cachePath, path, *mesh);
+
+  return mesh;
+}
+
+void lpe::MeshRegistry::GenerateLods(Mesh& mesh, const MeshOptions& options)
+{
+  // a level has to save at least this share of the previous one to be worth keeping
+  const float minimumReduction = 0.1f;
+
+  mesh.lods.clear();
+  mesh.lods.push_back({ 0, (uint32_t)mesh.indices.size(), 0.0f });
+
+  std::vector<uint32_t> previous = mesh.indices;
+
+  for (uint32_t lod = 1; lod < options.lodCount; lod++)
+  {
+    const uint32_t target = (uint32_t)(previous.size() / 3 * options.lodReduction) * 3;
+
+    float error = 0.0f;
+    auto simplified = MeshSimplifier::Simplify(mesh.vertices, previous, target, error);
+
+    if (simplified.empty() || simplified.size() > previous.size() * (1.0f - minimumReduction))
+    {
+      break;
+    }
+
+    if (options.optimizeVertexCache)
+    {
+      MeshOptimizer::OptimizeVertexCache(simplified, (uint32_t)mesh.vertices.size());
+    }
+
+    // errors of the levels add up, each one is simplified from the previous one
+    mesh.lods.push_back({ (uint32_t)mesh.indices.size(), (uint32_t)simplified.size(), mesh.lods.back().error + error });
+    mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+
+    previous = std::move(simplified);
+  }
+}
+
+lpe::MeshRegistry& lpe::MeshRegistry::Shared()
+{
+  static MeshRegistry registry;
+
+  return registry;
+}
@@ -0,0 +1,450 @@
+#include "../include/MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+  // boundaries are kept in place by planes perpendicular to the surface, weighted relative to the surface planes
+  const double BoundaryWeight = 10.0;
+
+  struct Quadric
+  {
+    double a00, a01, a02, a03;
+    double a11, a12, a13;
+    double a22, a23;
+    double a33;
+    double weight;
+
+    void AddPlane(glm::vec3 normal, float distance, double planeWeight)
+    {
+      const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+
+      a00 += x * x * planeWeight; a01 += x * y * planeWeight; a02 += x * z * planeWeight; a03 += x * d * planeWeight;
+      a11 += y * y * planeWeight; a12 += y * z * planeWeight; a13 += y * d * planeWeight;
+      a22 += z * z * planeWeight; a23 += z * d * planeWeight;
+      a33 += d * d * planeWeight;
+    }
+
+    void Add(const Quadric& other)
+    {
+      a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+      a11 += other.a11; a12 += other.a12; a13 += other.a13;
+      a22 += other.a22; a23 += other.a23;
+      a33 += other.a33;
+      weight += other.weight;
+    }
+
+    // squared distance to the accumulated planes, averaged over the surface area
+    double Evaluate(glm::vec3 point) const
+    {
+      const double x = point.x, y = point.y, z = point.z;
+
+      const double error = a00 * x * x + a11 * y * y + a22 * z * z +
+                           2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                           2.0 * (a03 * x + a13 * y + a23 * z) +
+                           a33;
+
+      return std::max(error, 0.0) / (weight > 0.0 ? weight : 1.0);
+    }
+  };
+
+  struct Collapse
+  {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+  };
+
+  // hashes and compares a fixed number of leading floats of a vertex bitwise
+  template <size_t Count>
+  struct VertexKey
+  {
+    size_t operator()(const lpe::Vertex* vertex) const
+    {
+      uint32_t bits[Count];
+      memcpy(bits, &vertex->position.x, sizeof(bits));
+
+      size_t hash = 0;
+      for (auto value : bits)
+      {
+        hash = (hash ^ value) * 0x100000001b3ull;
+      }
+
+      return hash;
+    }
+
+    bool operator()(const lpe::Vertex* a, const lpe::Vertex* b) const
+    {
+      return memcmp(&a->position.x, &b->position.x, Count * sizeof(float)) == 0;
+    }
+  };
+
+  // maps every vertex to the first vertex with the same leading floats
+  template <size_t Count>
+  std::vector<uint32_t> GroupVertices(const std::vector<lpe::Vertex>& vertices)
+  {
+    std::unordered_map<const lpe::Vertex*, uint32_t, VertexKey<Count>, VertexKey<Count>> groups;
+    groups.reserve(vertices.size());
+
+    std::vector<uint32_t> representatives(vertices.size());
+
+    for (uint32_t i = 0; i < vertices.size(); i++)
+    {
+      representatives[i] = groups.insert(std::make_pair(&vertices[i], i)).first->second;
+    }
+
+    return representatives;
+  }
+
+  glm::vec3 GetNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+  {
+    return glm::cross(b - a, c - a);
+  }
+}
+
+std::vector<uint32_t> lpe::MeshSimplifier::Simplify(const std::vector<Vertex>& vertices,
+                                                    const std::vector<uint32_t>& indices,
+                                                    uint32_t targetIndexCount,
+                                                    float& error)
+{
+  static_assert(offsetof(Vertex, color) == 3 * sizeof(float), "the color has to follow the position");
+
+  const uint32_t vertexCount = (uint32_t)vertices.size();
+
+  error = 0.0f;
+
+  // wedges are vertices which only differ in their normal, the simplification treats them as one vertex
+  const auto wedges = GroupVertices<6>(vertices);
+  const auto positions = GroupVertices<3>(vertices);
+
+  // the wedges of a position have to move together or the colors would tear apart, they are not collapsed at all
+  std::vector<uint8_t> locked(vertexCount, 0);
+  {
+    std::vector<uint32_t> positionWedges(vertexCount, ~0u);
+
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+      auto& first = positionWedges[positions[vertex]];
+
+      if (first == ~0u)
+      {
+        first = wedges[vertex];
+      }
+      else if (first != wedges[vertex])
+      {
+        locked[first] = 1;
+        locked[wedges[vertex]] = 1;
+      }
+    }
+  }
+
+  std::vector<uint32_t> result(indices.size() - indices.size() % 3);
+  for (size_t i = 0; i < result.size(); i++)
+  {
+    result[i] = wedges[indices[i]];
+  }
+
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+  std::vector<uint32_t> adjacency;
+  std::vector<uint64_t> edges;
+  std::vector<uint8_t> borderEdges;
+  std::vector<uint8_t> border(vertexCount);
+  std::vector<Quadric> quadrics(vertexCount);
+  std::vector<Collapse> collapses;
+  std::vector<uint32_t> remap(vertexCount);
+  std::vector<uint8_t> touched(vertexCount);
+
+  // every pass collapses each vertex at most once, so the costs computed at the start of the pass stay valid
+  while (result.size() > targetIndexCount)
+  {
+    const uint32_t triangleCount = (uint32_t)(result.size() / 3);
+
+    std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+    for (auto vertex : result)
+    {
+      adjacencyOffsets[vertex + 1]++;
+    }
+
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+      adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+    }
+
+    adjacency.resize(result.size());
+    {
+      std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+      for (uint32_t i = 0; i < result.size(); i++)
+      {
+        adjacency[fill[result[i]]++] = i / 3;
+      }
+    }
+
+    // an edge is on the border if no other triangle uses it in the opposite direction
+    edges.resize(result.size());
+    for (uint32_t i = 0; i < result.size(); i++)
+    {
+      const uint32_t next = i - i % 3 + (i + 1) % 3;
+      edges[i] = ((uint64_t)result[i] << 32) | result[next];
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    borderEdges.assign(triangleCount, 0);
+    std::fill(border.begin(), border.end(), 0);
+
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+      for (uint32_t edge = 0; edge < 3; edge++)
+      {
+        const uint32_t a = result[triangle * 3 + edge];
+        const uint32_t b = result[triangle * 3 + (edge + 1) % 3];
+
+        if (!std::binary_search(edges.begin(), edges.end(), ((uint64_t)b << 32) | a))
+        {
+          borderEdges[triangle] |= 1 << edge;
+          border[a] = 1;
+          border[b] = 1;
+        }
+      }
+    }
+
+    std::fill(quadrics.begin(), quadrics.end(), Quadric{});
+
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+      const uint32_t* corners = &result[triangle * 3];
+      const glm::vec3 p[3] = { vertices[corners[0]].position, vertices[corners[1]].position, vertices[corners[2]].position };
+
+      glm::vec3 normal = GetNormal(p[0], p[1], p[2]);
+      const float doubleArea = glm::length(normal);
+
+      if (doubleArea <= 0.0f)
+      {
+        continue;
+      }
+
+      normal /= doubleArea;
+
+      Quadric plane = {};
+      plane.AddPlane(normal, -glm::dot(normal, p[0]), doubleArea * 0.5);
+      plane.weight = doubleArea * 0.5;
+
+      for (uint32_t corner = 0; corner < 3; corner++)
+      {
+        quadrics[corners[corner]].Add(plane);
+
+        if (borderEdges[triangle] & (1 << corner))
+        {
+          const glm::vec3 edge = p[(corner + 1) % 3] - p[corner];
+          const float length = glm::length(edge);
+
+          if (length > 0.0f)
+          {
+            const glm::vec3 edgeNormal = glm::normalize(glm::cross(edge, normal));
+
+            Quadric edgePlane = {};
+            edgePlane.AddPlane(edgeNormal, -glm::dot(edgeNormal, p[corner]), length * length * BoundaryWeight);
+
+            quadrics[corners[corner]].Add(edgePlane);
+            quadrics[corners[(corner + 1) % 3]].Add(edgePlane);
+          }
+        }
+      }
+    }
+
+    collapses.clear();
+
+    for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+      for (uint32_t edge = 0; edge < 3; edge++)
+      {
+        const uint32_t a = result[triangle * 3 + edge];
+        const uint32_t b = result[triangle * 3 + (edge + 1) % 3];
+        const bool borderEdge = (borderEdges[triangle] & (1 << edge)) != 0;
+
+        // border vertices may only slide along the border
+        const uint32_t candidates[2][2] = { { a, b }, { b, a } };
+
+        for (const auto& candidate : candidates)
+        {
+          const uint32_t from = candidate[0];
+          const uint32_t to = candidate[1];
+
+          if (from == to || locked[from] || (border[from] && !borderEdge))
+          {
+            continue;
+          }
+
+          Quadric combined = quadrics[from];
+          combined.Add(quadrics[to]);
+
+          collapses.push_back({ from, to, combined.Evaluate(vertices[to].position) });
+        }
+      }
+    }
+
+    // interior edges are found from both of their triangles
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+    {
+      return a.from < b.from || (a.from == b.from && a.to < b.to);
+    });
+
+    collapses.erase(std::unique(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+    {
+      return a.from == b.from && a.to == b.to;
+    }), collapses.end());
+
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+    {
+      return a.cost < b.cost;
+    });
+
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+      remap[vertex] = vertex;
+    }
+
+    std::fill(touched.begin(), touched.end(), 0);
+
+    uint32_t remainingTriangles = triangleCount;
+    uint32_t collapsed = 0;
+
+    for (const auto& collapse : collapses)
+    {
+      if (remainingTriangles * 3 <= targetIndexCount)
+      {
+        break;
+      }
+
+      if (touched[collapse.from] || touched[collapse.to])
+      {
+        continue;
+      }
+
+      // reject collapses which would flip a triangle around the removed vertex
+      bool flipped = false;
+      uint32_t removedTriangles = 0;
+
+      for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; i++)
+      {
+        const uint32_t* corners = &result[adjacency[i] * 3];
+        const uint32_t c[3] = { remap[corners[0]], remap[corners[1]], remap[corners[2]] };
+
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2])
+        {
+          // already removed by an earlier collapse of this pass
+          continue;
+        }
+
+        if (c[0] == collapse.to || c[1] == collapse.to || c[2] == collapse.to)
+        {
+          removedTriangles++;
+          continue;
+        }
+
+        glm::vec3 before[3];
+        glm::vec3 after[3];
+
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+          before[corner] = vertices[c[corner]].position;
+          after[corner] = c[corner] == collapse.from ? vertices[collapse.to].position : before[corner];
+        }
+
+        if (glm::dot(GetNormal(before[0], before[1], before[2]), GetNormal(after[0], after[1], after[2])) <= 0.0f)
+        {
+          flipped = true;
+          break;
+        }
+      }
+
+      if (flipped)
+      {
+        continue;
+      }
+
+      remap[collapse.from] = collapse.to;
+      touched[collapse.from] = 1;
+      touched[collapse.to] = 1;
+
+      remainingTriangles -= removedTriangles;
+      collapsed++;
+
+      error = std::max(error, (float)std::sqrt(collapse.cost));
+    }
+
+    if (collapsed == 0)
+    {
+      break;
+    }
+
+    // drop the triangles which became degenerate
+    size_t write = 0;
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      const uint32_t a = remap[result[i]];
+      const uint32_t b = remap[result[i + 1]];
+      const uint32_t c = remap[result[i + 2]];
+
+      if (a != b && b != c && a != c)
+      {
+        result[write++] = a;
+        result[write++] = b;
+        result[write++] = c;
+      }
+    }
+
+    result.resize(write);
+  }
+
+  // each corner uses the wedge whose normal fits the simplified triangle best
+  std::vector<uint32_t> wedgeOffsets(vertexCount + 1, 0);
+  std::vector<uint32_t> wedgeMembers(vertexCount);
+
+  for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+  {
+    wedgeOffsets[wedges[vertex] + 1]++;
+  }
+
+  for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+  {
+    wedgeOffsets[vertex + 1] += wedgeOffsets[vertex];
+  }
+
+  {
+    std::vector<uint32_t> fill(wedgeOffsets.begin(), wedgeOffsets.end() - 1);
+
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+      wedgeMembers[fill[wedges[vertex]]++] = vertex;
+    }
+  }
+
+  for (size_t i = 0; i < result.size(); i += 3)
+  {
+    const glm::vec3 normal = GetNormal(vertices[result[i]].position, vertices[result[i + 1]].position, vertices[result[i + 2]].position);
+
+    for (size_t corner = i; corner < i + 3; corner++)
+    {
+      const uint32_t wedge = result[corner];
+      float best = -INFINITY;
+
+      for (uint32_t member = wedgeOffsets[wedge]; member < wedgeOffsets[wedge + 1]; member++)
+      {
+        const float fit = glm::dot(vertices[wedgeMembers[member]].normals, normal);
+
+        if (fit > best)
+        {
+          best = fit;
+          result[corner] = wedgeMembers[member];
+        }
+      }
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,149 @@
+#include "../include/MeshletBuilder.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  const uint8_t NotInMeshlet = 0xff;
+
+  void ComputeBounds(const lpe::Mesh& mesh, lpe::Meshlet& meshlet)
+  {
+    const uint32_t* vertices = &mesh.meshletVertices[meshlet.vertexOffset];
+    const uint8_t* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+
+    glm::vec3 min = mesh.vertices[vertices[0]].position;
+    glm::vec3 max = min;
+
+    for (uint32_t i = 1; i < meshlet.vertexCount; i++)
+    {
+      min = glm::min(min, mesh.vertices[vertices[i]].position);
+      max = glm::max(max, mesh.vertices[vertices[i]].position);
+    }
+
+    meshlet.center = (min + max) * 0.5f;
+    meshlet.radius = 0.0f;
+
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+      meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, mesh.vertices[vertices[i]].position));
+    }
+
+    // the axis is the average of the unit triangle normals, the cone has to contain every one of them
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.triangleCount);
+
+    glm::vec3 axis(0.0f);
+
+    for (uint32_t i = 0; i < meshlet.triangleCount; i++)
+    {
+      const glm::vec3 a = mesh.vertices[vertices[triangles[i * 3]]].position;
+      const glm::vec3 b = mesh.vertices[vertices[triangles[i * 3 + 1]]].position;
+      const glm::vec3 c = mesh.vertices[vertices[triangles[i * 3 + 2]]].position;
+
+      const glm::vec3 normal = glm::cross(b - a, c - a);
+      const float length = glm::length(normal);
+
+      if (length > 0.0f)
+      {
+        normals.push_back(normal / length);
+        axis += normals.back();
+      }
+    }
+
+    meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = 1.0f;
+
+    const float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength <= 0.0f)
+    {
+      return;
+    }
+
+    axis /= axisLength;
+
+    float minimumDot = 1.0f;
+    for (const auto& normal : normals)
+    {
+      minimumDot = std::min(minimumDot, glm::dot(axis, normal));
+    }
+
+    meshlet.coneAxis = axis;
+
+    // normals spread over a hemisphere or more, some triangle faces every direction
+    if (minimumDot > 0.0f)
+    {
+      meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+    }
+  }
+}
+
+void lpe::MeshletBuilder::Build(Mesh& mesh)
+{
+  mesh.meshlets.clear();
+  mesh.meshletVertices.clear();
+  mesh.meshletTriangles.clear();
+
+  const uint32_t indexCount = mesh.lods.empty() ? (uint32_t)mesh.indices.size() : mesh.lods[0].indexCount;
+  const uint32_t* indices = mesh.indices.data();
+
+  std::vector<uint8_t> localIndices(mesh.vertices.size(), NotInMeshlet);
+
+  Meshlet meshlet = {};
+
+  auto finish = [&mesh, &meshlet, &localIndices]()
+  {
+    if (meshlet.triangleCount == 0)
+    {
+      return;
+    }
+
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+      localIndices[mesh.meshletVertices[meshlet.vertexOffset + i]] = NotInMeshlet;
+    }
+
+    ComputeBounds(mesh, meshlet);
+    mesh.meshlets.push_back(meshlet);
+
+    // keeps the triangles of every meshlet 4 byte aligned for gpu upload
+    mesh.meshletTriangles.resize((mesh.meshletTriangles.size() + 3) & ~size_t(3));
+
+    meshlet = {};
+    meshlet.vertexOffset = (uint32_t)mesh.meshletVertices.size();
+    meshlet.triangleOffset = (uint32_t)mesh.meshletTriangles.size();
+  };
+
+  for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+  {
+    const uint32_t corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+
+    uint32_t newVertices = 0;
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+      const bool repeated = corner > 0 && std::find(corners, corners + corner, corners[corner]) != corners + corner;
+      newVertices += localIndices[corners[corner]] == NotInMeshlet && !repeated ? 1 : 0;
+    }
+
+    if (meshlet.vertexCount + newVertices > MaxVertices || meshlet.triangleCount + 1 > MaxTriangles)
+    {
+      finish();
+    }
+
+    for (auto vertex : corners)
+    {
+      auto& local = localIndices[vertex];
+
+      if (local == NotInMeshlet)
+      {
+        local = (uint8_t)meshlet.vertexCount++;
+        mesh.meshletVertices.push_back(vertex);
+      }
+
+      mesh.meshletTriangles.push_back(local);
+    }
+
+    meshlet.triangleCount++;
+  }
+
+  finish();
+}
@@ -1,5 +1,7 @@
 #include "../include/Model.h"
-#include <sstream>
+#include "../include/PlyFile.h"
+#include "../include/InstanceCompose.h"
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 
 void lpe::Model::Copy(const Model& other)
@@ -49,112 +51,7 @@ lpe::Model& lpe::Model::operator=(Model&& other)
 
 void lpe::Model::Load(std::string fileName)
 {
-	// simply load ply file
-	// ignoring header!
-
-	std::ifstream file(fileName);
-
-	if (!file)
-	{
-		std::runtime_error("Failed to open model " + fileName);
-	}
-
-	std::string line;
-	bool header = true;
-	uint32_t countVertices = ~0u;
-	uint32_t countFaces = ~0u;
-
-	while (std::getline(file, line))
-	{
-		if (header)
-		{
-			int32_t find = (int32_t)line.find("element vertex");
-			if (find >= 0)
-			{
-				countVertices = std::stoi(line.substr(line.find_last_of(" ") + 1));
-				continue;
-			}
-
-			find = (int32_t)line.find("element face");
-			if (find >= 0)
-			{
-				countFaces = std::stoi(line.substr(line.find_last_of(" ") + 1));
-				continue;
-			}
-
-			if (line == "end_header")
-			{
-				header = false;
-				break;
-			}
-		}
-	}
-
-	if (header || countVertices == -1 || countFaces == -1)
-	{
-		throw std::runtime_error("file doesn't have the right format");
-	}
-
-	vertices.resize(countVertices);
-	for (uint32_t i = 0; i < countVertices; i++)
-	{
-		std::getline(file, line);
-
-		std::istringstream linepart(line);
-		std::string part;
-		uint16_t index = 0;
-		Vertex v;
-
-		while (std::getline(linepart, part, ' '))
-		{
-			if (index <= 2)
-			{
-				v.position[index] = std::stof(part);
-			}
-			else if (index <= 5)
-			{
-				v.normals[index % 3] = std::stof(part);
-			}
-			else if (index <= 8)
-			{
-				v.color[index % 3] = std::stof(part) / 255.f;
-			}
-			else
-			{
-				break;
-			}
-			index++;
-		}
-
-		vertices[i] = v;
-	}
-
-	indices.resize(countFaces * 3);
-	for (uint32_t i = 0; i < countFaces; i++)
-	{
-		std::getline(file, line);
-
-		std::istringstream linepart(line);
-		std::string part;
-		uint16_t index = 0;
-
-		while (std::getline(linepart, part, ' '))
-		{
-			if (index == 0 && std::stoi(part) != 3)
-			{
-				throw std::runtime_error("faces are not triangulated!");
-			}
-
-			if (index > 0)
-			{
-				indices[(i * 3 + index - 1)] = std::stoi(part);
-			}
-
-			index++;
-		}
-	}
-
-	file.close();
+	PlyFile(fileName).Read(vertices, indices, ThreadPool::Shared());
 }
 
 void lpe::Model::SetVertices(const std::vector<lpe::Vertex>& vertices)
@@ -220,13 +117,7 @@ lpe::InstanceData lpe::Model::GetInstanceData()
 {
   InstanceData instanceData;
 
-  glm::mat4 matrix = glm::translate(glm::mat4(1.0f), position);
-  matrix = matrix * this->matrix;
-
-  instanceData.row1 = matrix[0];
-  instanceData.row2 = matrix[1];
-  instanceData.row3 = matrix[2];
-  instanceData.row4 = matrix[3];
+  ComposeInstances(&position, &matrix, nullptr, 1, &instanceData);
 
   return instanceData;
 }
@@ -1,14 +1,86 @@
 #include "../include/ModelsRenderer.h"
+#include "../include/Palette.h"
+#include "../include/StaticBaker.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  // the current buffers are the copy source when new geometry is appended (see BeginUpload)
+  const vk::BufferUsageFlags GeometryUsage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+
+  // the coarsest level whose error, projected to the screen, stays below the threshold
+  uint32_t SelectLod(const lpe::Mesh& mesh, const lpe::InstanceData& instance, glm::vec3 eye, float pixelsPerUnit, float threshold)
+  {
+    if (mesh.lods.size() < 2)
+    {
+      return 0;
+    }
+
+    const glm::vec3 center = glm::vec3(instance.row1) * mesh.center.x +
+                             glm::vec3(instance.row2) * mesh.center.y +
+                             glm::vec3(instance.row3) * mesh.center.z +
+                             glm::vec3(instance.row4);
+
+    const float scale = std::max(glm::length(glm::vec3(instance.row1)), std::max(glm::length(glm::vec3(instance.row2)), glm::length(glm::vec3(instance.row3))));
+
+    // measured from the closest point of the bounding sphere, a camera inside of it always gets the full mesh
+    const float distance = glm::distance(center, eye) - mesh.radius * scale;
+    if (distance <= 0.0f)
+    {
+      return 0;
+    }
+
+    for (uint32_t lod = (uint32_t)mesh.lods.size() - 1; lod > 0; --lod)
+    {
+      if (mesh.lods[lod].error * scale * pixelsPerUnit / distance <= threshold)
+      {
+        return lod;
+      }
+    }
+
+    return 0;
+  }
+
+  lpe::IndexFormat GetIndexFormat(lpe::ObjectRef obj)
+  {
+    auto mesh = obj->GetMesh();
+
+    return mesh ? mesh->GetIndexFormat() : lpe::IndexFormat::Uint32;
+  }
+
+  // quantized positions are relative to the bounding sphere, scaling and moving the instance matrix undoes that
+  void Dequantize(lpe::InstanceData& instance, glm::vec3 center, float radius)
+  {
+    instance.row4 = instance.row1 * center.x + instance.row2 * center.y + instance.row3 * center.z + instance.row4;
+    instance.row1 = instance.row1 * radius;
+    instance.row2 = instance.row2 * radius;
+    instance.row3 = instance.row3 * radius;
+  }
+}
 
 void lpe::ModelsRenderer::Copy(const ModelsRenderer& other)
 {
   this->commands.reset(other.commands.get());
   this->indices = { other.indices };
   this->vertices = { other.vertices };
+  this->meshRanges = { other.meshRanges };
+  this->staticChunks = { other.staticChunks };
+  this->chunkSize = other.chunkSize;
   this->objects = { other.objects };
-  this->indexBuffer = { other.indexBuffer };
-  this->vertexBuffer = { other.vertexBuffer };
+  this->queuedObjects = { other.queuedObjects };
+  this->indexBuffers = { other.indexBuffers };
+  this->vertexBuffers = { other.vertexBuffers };
 	this->indirectBuffer = { other.indirectBuffer };
+  this->drawCommands = { other.drawCommands };
+  this->drawGroups = other.drawGroups;
+  this->lodThreshold = other.lodThreshold;
+  this->instanceData = { other.instanceData };
+  this->animationData = { other.animationData };
+  this->objectInstances = { other.objectInstances };
+  this->lodEye = other.lodEye;
+  this->lodPixelsPerUnit = other.lodPixelsPerUnit;
+  this->lodSelectedThreshold = other.lodSelectedThreshold;
 }
 
 void lpe::ModelsRenderer::Move(ModelsRenderer& other)
@@ -16,9 +88,24 @@ void lpe::ModelsRenderer::Move(ModelsRenderer& other)
   this->commands = std::move(other.commands);
   this->indices = std::move(other.indices);
   this->vertices = std::move(other.vertices);
-  this->indexBuffer = std::move(other.indexBuffer);
-  this->vertexBuffer = std::move(other.vertexBuffer);
+  this->meshRanges = std::move(other.meshRanges);
+  this->staticChunks = std::move(other.staticChunks);
+  this->chunkSize = other.chunkSize;
+  this->objects = std::move(other.objects);
+  this->queuedObjects = std::move(other.queuedObjects);
+  this->upload = std::move(other.upload);
+  this->indexBuffers = std::move(other.indexBuffers);
+  this->vertexBuffers = std::move(other.vertexBuffers);
 	this->indirectBuffer = std::move(other.indirectBuffer);
+  this->drawCommands = std::move(other.drawCommands);
+  this->drawGroups = other.drawGroups;
+  this->lodThreshold = other.lodThreshold;
+  this->instanceData = std::move(other.instanceData);
+  this->animationData = std::move(other.animationData);
+  this->objectInstances = std::move(other.objectInstances);
+  this->lodEye = other.lodEye;
+  this->lodPixelsPerUnit = other.lodPixelsPerUnit;
+  this->lodSelectedThreshold = other.lodSelectedThreshold;
 }
 
 lpe::ModelsRenderer::ModelsRenderer(const ModelsRenderer& other)
@@ -49,13 +136,28 @@ lpe::ModelsRenderer::ModelsRenderer(vk::PhysicalDevice physicalDevice, vk::Devic
   this->device.reset(device);
   this->commands.reset(commands);
 
-  indexBuffer = { physicalDevice, device };
-  vertexBuffer = { physicalDevice, device };
+  for (auto& vertexBuffer : vertexBuffers)
+  {
+    vertexBuffer = { physicalDevice, device };
+  }
+
+  for (auto& indexBuffer : indexBuffers)
+  {
+    indexBuffer = { physicalDevice, device };
+  }
+
 	indirectBuffer = { physicalDevice, device };
 }
 
 lpe::ModelsRenderer::~ModelsRenderer()
 {
+  if(upload && commands)
+  {
+    commands->WaitFor(upload->fence);
+    commands->FreeSingleTimeCommands(upload->commandBuffer, upload->fence);
+    upload.reset();
+  }
+
   if(commands)
   {
     commands.release();
@@ -68,88 +170,598 @@ lpe::ModelsRenderer::~ModelsRenderer()
 }
 
 std::vector<vk::DrawIndexedIndirectCommand> lpe::ModelsRenderer::GetDrawIndexedIndirectCommands()
+{
+	return drawCommands;
+}
+
+std::vector<vk::DrawIndexedIndirectCommand> lpe::ModelsRenderer::GetDrawIndexedIndirectCommands(const std::vector<ObjectRef>& objects)
 {
 	std::vector<vk::DrawIndexedIndirectCommand> commands = {};
 
+	// every instance starts with the full mesh, UpdateInstanceData moves them to other levels each frame
 	uint32_t i = 0;
 	for (auto& entry : objects)
 	{
-		commands.push_back(entry->GetIndirectCommand(i));
+    for (uint32_t lod = 0; lod < entry->GetLodCount(); ++lod)
+    {
+      commands.push_back(entry->GetIndirectCommand(lod, lod == 0 ? entry->GetInstanceCount() : 0, i));
+    }
+
     i += entry->GetInstanceCount();
 	}
 
 	return commands;
 }
 
-std::vector<lpe::InstanceData> lpe::ModelsRenderer::GetInstanceData() const
+void lpe::ModelsRenderer::UpdateInstanceData(const Camera& camera, std::vector<InstanceRange>& changed)
 {
-  std::vector<lpe::InstanceData> instances;
+  changed.clear();
+  drawCommands.clear();
+
+  const glm::vec3 eye = camera.GetPosition();
+
+  // pixels covered by one unit at a distance of one unit
+  const float pixelsPerUnit = camera.GetPerspective()[1][1] * camera.GetExtent().height * 0.5f;
+
+  const bool lodChanged = eye != lodEye || pixelsPerUnit != lodPixelsPerUnit || lodThreshold != lodSelectedThreshold;
+  lodEye = eye;
+  lodPixelsPerUnit = pixelsPerUnit;
+  lodSelectedThreshold = lodThreshold;
 
+  uint32_t instanceCount = 0;
   for (const auto& entry : objects)
   {
-    auto instanceData = entry->GetInstanceData();
-    instances.insert(std::end(instances), std::begin(instanceData), std::end(instanceData));
+    instanceCount += entry->GetInstanceCount();
+  }
+
+  instanceData.resize(instanceCount);
+  animationData.resize(instanceCount);
+  objectInstances.resize(objects.size());
+
+  std::vector<lpe::InstanceData> packedInstances;
+  std::vector<lpe::AnimationData> packedAnimations;
+
+  uint32_t first = 0;
+
+  for (size_t i = 0; i < objects.size(); ++i)
+  {
+    const auto& entry = objects[i];
+    auto& cached = objectInstances[i];
+    const uint32_t count = entry->GetInstanceCount();
+    const uint32_t version = entry->GetInstances().GetVersion();
+
+    // an object which moved to another offset is written again, the instances before it are left alone
+    const bool unchanged = cached.object == entry && cached.version == version && cached.first == first && cached.count == count &&
+                           (!lodChanged || cached.lodCounts.size() < 2);
+
+    if (!unchanged)
+    {
+      packedInstances.clear();
+      packedAnimations.clear();
+      entry->GetInstanceData(packedInstances, packedAnimations);
+      auto mesh = entry->GetMesh();
+      const uint32_t lodCount = entry->GetLodCount();
+
+      if (lodInstances.size() < lodCount)
+      {
+        lodInstances.resize(lodCount);
+        lodAnimations.resize(lodCount);
+      }
+
+      for (uint32_t lod = 0; lod < lodCount; ++lod)
+      {
+        lodInstances[lod].clear();
+        lodAnimations[lod].clear();
+      }
+
+      for (size_t instance = 0; instance < packedInstances.size(); ++instance)
+      {
+        const uint32_t lod = mesh ? SelectLod(*mesh, packedInstances[instance], eye, pixelsPerUnit, lodThreshold) : 0;
+        lodInstances[lod].push_back(packedInstances[instance]);
+        lodAnimations[lod].push_back(packedAnimations[instance]);
+
+        if (mesh && mesh->format != VertexFormat::Float)
+        {
+          Dequantize(lodInstances[lod].back(), mesh->center, mesh->radius);
+        }
+      }
+
+      cached.object = entry;
+      cached.version = version;
+      cached.first = first;
+      cached.count = count;
+      cached.lodCounts.resize(lodCount);
+
+      uint32_t offset = first;
+      for (uint32_t lod = 0; lod < lodCount; ++lod)
+      {
+        std::copy(std::begin(lodInstances[lod]), std::end(lodInstances[lod]), std::begin(instanceData) + offset);
+        std::copy(std::begin(lodAnimations[lod]), std::end(lodAnimations[lod]), std::begin(animationData) + offset);
+
+        cached.lodCounts[lod] = (uint32_t)lodInstances[lod].size();
+        offset += cached.lodCounts[lod];
+      }
+
+      if (!changed.empty() && changed.back().first + changed.back().count == first)
+      {
+        changed.back().count += count;
+      }
+      else if (count > 0)
+      {
+        changed.push_back({ first, count });
+      }
+    }
+
+    uint32_t offset = first;
+    for (uint32_t lod = 0; lod < (uint32_t)cached.lodCounts.size(); ++lod)
+    {
+      drawCommands.push_back(entry->GetIndirectCommand(lod, cached.lodCounts[lod], offset));
+      offset += cached.lodCounts[lod];
+    }
+
+    first += count;
+  }
+
+  // the gpu is idle between frames (presentQueue.waitIdle in Device::SubmitFrame), so the commands can be overwritten in place
+  if (!drawCommands.empty() && indirectBuffer.GetBuffer())
+  {
+    indirectBuffer.CopyToBufferMemory(drawCommands.data(), drawCommands.size() * sizeof(vk::DrawIndexedIndirectCommand));
   }
+}
 
-  return instances;
+const std::vector<lpe::InstanceData>& lpe::ModelsRenderer::GetInstanceData() const
+{
+  return instanceData;
+}
+
+const std::vector<lpe::AnimationData>& lpe::ModelsRenderer::GetAnimationData() const
+{
+  return animationData;
+}
+
+void lpe::ModelsRenderer::SetLodThreshold(float pixels)
+{
+  lodThreshold = pixels;
+}
+
+void lpe::ModelsRenderer::SetChunkSize(float size)
+{
+  chunkSize = size;
+}
+
+lpe::VertexFormat lpe::ModelsRenderer::GetVertexFormat(ObjectRef obj) const
+{
+  auto mesh = obj->GetMesh();
+
+  if (!mesh)
+  {
+    return VertexFormat::Float;
+  }
+
+  // the range knows if the mesh was stored in another format than its own
+  auto range = meshRanges.find(mesh.get());
+
+  return range != meshRanges.end() ? range->second.format : mesh->format;
+}
+
+bool lpe::ModelsRenderer::AssignRange(ObjectRef obj)
+{
+  auto mesh = obj->GetMesh();
+  auto range = meshRanges.find(mesh.get());
+  bool geometryChanged = false;
+
+  // objects which share a mesh share its vertices and indices as well, only the first one is appended
+  if (range == meshRanges.end())
+  {
+    auto vertexFormat = GetVertexFormat(obj);
+    const auto indexFormat = GetIndexFormat(obj);
+
+    // the colors of the mesh are merged into the shared palette before anything is appended
+    // if they don't fit, the mesh is stored as FlatVertex, which is shaded the same way
+    std::vector<uint32_t> colors;
+    if (vertexFormat == VertexFormat::Palette && !Palette::Shared().Add(mesh->palette, colors))
+    {
+      vertexFormat = VertexFormat::Flat;
+    }
+
+    auto& vertexStream = vertices[(uint32_t)vertexFormat];
+    auto& indexStream = indices[(uint32_t)indexFormat];
+
+    // offsets count vertices and indices of the streams the mesh ends up in
+    MeshRange entry = { mesh, (uint32_t)(indexStream.size() / GetIndexStride(indexFormat)), (int32_t)(vertexStream.size() / GetVertexStride(vertexFormat)), vertexFormat };
+
+    if (mesh)
+    {
+      const size_t vertexStart = vertexStream.size();
+
+      if (vertexFormat != mesh->format)
+      {
+        // both are quantized to the bounding sphere, so the instance matrices stay the same
+        vertexStream.resize(vertexStart + mesh->GetVertexCount() * sizeof(FlatVertex));
+        auto flat = reinterpret_cast<FlatVertex*>(vertexStream.data() + vertexStart);
+
+        for (uint32_t i = 0; i < mesh->GetVertexCount(); ++i)
+        {
+          flat[i] = FlatVertex::Pack(mesh->paletteVertices[i].Unpack(mesh->center, mesh->radius, mesh->palette), mesh->center, mesh->radius);
+        }
+      }
+      else
+      {
+        auto data = static_cast<const uint8_t*>(mesh->GetVertexData());
+        vertexStream.insert(std::end(vertexStream), data, data + mesh->GetVertexCount() * GetVertexStride(vertexFormat));
+      }
+
+      if (vertexFormat == VertexFormat::Palette)
+      {
+        auto packed = reinterpret_cast<PaletteVertex*>(vertexStream.data() + vertexStart);
+
+        for (uint32_t i = 0; i < mesh->GetVertexCount(); ++i)
+        {
+          packed[i].color = (uint16_t)colors[packed[i].color];
+        }
+      }
+
+      const size_t indexStart = indexStream.size();
+      indexStream.resize(indexStart + mesh->indices.size() * GetIndexStride(indexFormat));
+
+      if (indexFormat == IndexFormat::Uint16)
+      {
+        auto narrowed = reinterpret_cast<uint16_t*>(indexStream.data() + indexStart);
+
+        for (size_t i = 0; i < mesh->indices.size(); ++i)
+        {
+          narrowed[i] = (uint16_t)mesh->indices[i];
+        }
+      }
+      else
+      {
+        memcpy(indexStream.data() + indexStart, mesh->indices.data(), mesh->indices.size() * sizeof(uint32_t));
+      }
+
+      geometryChanged = true;
+    }
+
+    range = meshRanges.insert(std::make_pair(mesh.get(), entry)).first;
+  }
+
+  obj->SetOffsets(range->second.indexOffset, range->second.vertexOffset);
+
+  return geometryChanged;
+}
+
+std::vector<lpe::ObjectRef> lpe::ModelsRenderer::BakeStatic(const std::vector<ObjectRef>& ready)
+{
+  StaticBaker baker(chunkSize);
+  std::vector<InstanceData> baked;
+
+  for (auto obj : ready)
+  {
+    auto mesh = obj->GetMesh();
+
+    if (!mesh)
+    {
+      continue;
+    }
+
+    baked.clear();
+    obj->GetInstances().Bake(baked);
+
+    for (const auto& instance : baked)
+    {
+      baker.Add(*mesh, instance);
+    }
+  }
+
+  // the chunks are in world space already, their only instance doesn't move them
+  std::vector<ObjectRef> chunks;
+
+  for (const auto& mesh : baker.Build())
+  {
+    staticChunks.push_back(std::make_shared<RenderObject>(mesh, 0));
+    staticChunks.back()->AddInstance();
+    chunks.push_back(staticChunks.back().get());
+  }
+
+  return chunks;
+}
+
+void lpe::ModelsRenderer::SortObjects()
+{
+  // stable, so objects of the same formats keep the order they were added in
+  std::stable_sort(std::begin(objects), std::end(objects), [this](ObjectRef a, ObjectRef b)
+  {
+    const auto formatA = GetVertexFormat(a);
+    const auto formatB = GetVertexFormat(b);
+
+    return formatA < formatB || (formatA == formatB && GetIndexFormat(a) < GetIndexFormat(b));
+  });
 }
 
 void lpe::ModelsRenderer::AddObject(ObjectRef obj)
 {
-  int32_t vertexOffset = (int32_t)vertices.size();
-  uint32_t indexOffset = (uint32_t)indices.size();
+  if (!obj->IsLoaded())
+  {
+    QueueObject(obj);
+    return;
+  }
+
+  // a running upload was built from the current buffers
+  WaitForUpload();
 
-  obj->SetOffsets(indexOffset, vertexOffset);
+  bool geometryChanged = AssignRange(obj);
 
 	objects.push_back(obj);
 
-	this->vertices.insert(std::end(this->vertices), obj->GetVertexBegin(), obj->GetVertexEnd());
-	this->indices.insert(std::end(this->indices), obj->GetIndexBegin(), obj->GetIndexEnd());
+  for (auto chunk : BakeStatic({ obj }))
+  {
+    AssignRange(chunk);
+    objects.push_back(chunk);
+    geometryChanged = true;
+  }
 
-	UpdateBuffer();
+  SortObjects();
+
+  if (geometryChanged)
+  {
+    UpdateBuffer();
+  }
+  else
+  {
+    UpdateIndirectBuffer();
+  }
 }
 
+void lpe::ModelsRenderer::QueueObject(ObjectRef obj)
+{
+  queuedObjects.push_back(obj);
+}
 
-void lpe::ModelsRenderer::UpdateBuffer()
+bool lpe::ModelsRenderer::ProcessQueue()
+{
+  bool objectsAdded = false;
+
+  if (upload && commands->IsFinished(upload->fence))
+  {
+    FinishUpload();
+    objectsAdded = true;
+  }
+
+  if (!upload && !queuedObjects.empty())
+  {
+    std::vector<ObjectRef> ready;
+
+    for (size_t i = 0; i < queuedObjects.size(); ++i)
+    {
+      bool loaded = false;
+
+      try
+      {
+        loaded = queuedObjects[i]->IsLoaded();
+      }
+      catch (...)
+      {
+        // the object can never be drawn
+        queuedObjects.erase(std::begin(queuedObjects) + i);
+        throw;
+      }
+
+      if (loaded)
+      {
+        ready.push_back(queuedObjects[i]);
+      }
+    }
+
+    if (!ready.empty())
+    {
+      queuedObjects.erase(std::remove_if(std::begin(queuedObjects), std::end(queuedObjects), [&ready](ObjectRef obj)
+      {
+        return std::find(std::begin(ready), std::end(ready), obj) != std::end(ready);
+      }), std::end(queuedObjects));
+
+      BeginUpload(std::move(ready));
+    }
+  }
+
+  return objectsAdded;
+}
+
+bool lpe::ModelsRenderer::IsStreaming() const
+{
+  return upload || !queuedObjects.empty();
+}
+
+void lpe::ModelsRenderer::BeginUpload(std::vector<ObjectRef> ready)
+{
+  std::array<size_t, VertexFormatCount> residentVertices;
+  std::array<size_t, IndexFormatCount> residentIndices;
+
+  for (uint32_t format = 0; format < VertexFormatCount; format++)
+  {
+    residentVertices[format] = vertices[format].size();
+  }
+
+  for (uint32_t format = 0; format < IndexFormatCount; format++)
+  {
+    residentIndices[format] = indices[format].size();
+  }
+
+  // baked before the upload, so the chunks become resident together with the objects they were taken from
+  auto chunks = BakeStatic(ready);
+  ready.insert(std::end(ready), std::begin(chunks), std::end(chunks));
+
+  for (auto obj : ready)
+  {
+    AssignRange(obj);
+  }
+
+  upload = std::make_unique<GeometryUpload>();
+  upload->objects = std::move(ready);
+
+  auto commandBuffer = commands->BeginSingleTimeCommands();
+
+  // the new buffers start with a gpu side copy of the resident geometry, only the new part goes through staging memory
+  for (uint32_t format = 0; format < VertexFormatCount; format++)
+  {
+    if (vertices[format].size() > residentVertices[format])
+    {
+      vk::DeviceSize residentSize = residentVertices[format];
+      vk::DeviceSize vertexSize = vertices[format].size();
+
+      upload->vertexStaging[format] = { physicalDevice, device.get(), vertices[format].data() + residentSize, vertexSize - residentSize };
+      upload->vertexBuffers[format] = { physicalDevice, device.get(), vertexSize, GeometryUsage | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal };
+
+      if (residentSize > 0)
+      {
+        upload->vertexBuffers[format].Copy(vertexBuffers[format], commandBuffer, 0, 0, residentSize);
+      }
+
+      upload->vertexBuffers[format].Copy(upload->vertexStaging[format], commandBuffer, 0, residentSize, vertexSize - residentSize);
+    }
+  }
+
+  for (uint32_t format = 0; format < IndexFormatCount; format++)
+  {
+    if (indices[format].size() > residentIndices[format])
+    {
+      vk::DeviceSize residentSize = residentIndices[format];
+      vk::DeviceSize indexSize = indices[format].size();
+
+      upload->indexStaging[format] = { physicalDevice, device.get(), indices[format].data() + residentSize, indexSize - residentSize };
+      upload->indexBuffers[format] = { physicalDevice, device.get(), indexSize, GeometryUsage | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal };
+
+      if (residentSize > 0)
+      {
+        upload->indexBuffers[format].Copy(indexBuffers[format], commandBuffer, 0, 0, residentSize);
+      }
+
+      upload->indexBuffers[format].Copy(upload->indexStaging[format], commandBuffer, 0, residentSize, indexSize - residentSize);
+    }
+  }
+
+  upload->commandBuffer = commandBuffer;
+  upload->fence = commands->SubmitSingleTimeCommands(commandBuffer);
+}
+
+void lpe::ModelsRenderer::FinishUpload()
+{
+  // nothing draws from the old buffers anymore once the command buffers are recorded again
+  for (uint32_t format = 0; format < VertexFormatCount; format++)
+  {
+    if (upload->vertexBuffers[format].GetBuffer())
+    {
+      vertexBuffers[format].Destroy();
+      vertexBuffers[format] = std::move(upload->vertexBuffers[format]);
+    }
+  }
+
+  for (uint32_t format = 0; format < IndexFormatCount; format++)
+  {
+    if (upload->indexBuffers[format].GetBuffer())
+    {
+      indexBuffers[format].Destroy();
+      indexBuffers[format] = std::move(upload->indexBuffers[format]);
+    }
+  }
+
+  objects.insert(std::end(objects), std::begin(upload->objects), std::end(upload->objects));
+  SortObjects();
+  UpdateIndirectBuffer();
+
+  commands->FreeSingleTimeCommands(upload->commandBuffer, upload->fence);
+  upload.reset();
+}
+
+void lpe::ModelsRenderer::WaitForUpload()
 {
-  auto cmds = GetDrawIndexedIndirectCommands();
+  if (upload)
+  {
+    commands->WaitFor(upload->fence);
+    FinishUpload();
+  }
+}
 
-  vk::DeviceSize indexSize = sizeof(indices[0]) * indices.size();
-  vk::DeviceSize vertexSize = sizeof(vertices[0]) * vertices.size();
-  vk::DeviceSize indirectSize = cmds.size() * sizeof(vk::DrawIndexedIndirectCommand);
 
+void lpe::ModelsRenderer::UpdateBuffer()
+{
   /*indexBuffer = commands->CreateBuffer(indices.data(), indexSize);
   vertexBuffer = commands->CreateBuffer(vertices.data(), vertexSize);*/
 
-  vertexBuffer.CreateStaged(*commands, vertexSize, vertices.data(), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-  indexBuffer.CreateStaged(*commands, indexSize, indices.data(), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-  
-	indirectBuffer.CreateStaged(*commands, indirectSize, cmds.data(), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndirectBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  for (uint32_t format = 0; format < VertexFormatCount; format++)
+  {
+    if (!vertices[format].empty())
+    {
+      vertexBuffers[format].CreateStaged(*commands, vertices[format].size(), vertices[format].data(), GeometryUsage | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+    }
+  }
+
+  for (uint32_t format = 0; format < IndexFormatCount; format++)
+  {
+    if (!indices[format].empty())
+    {
+      indexBuffers[format].CreateStaged(*commands, indices[format].size(), indices[format].data(), GeometryUsage | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+    }
+  }
+
+  UpdateIndirectBuffer();
 }
 
-uint32_t lpe::ModelsRenderer::GetCount() const
+void lpe::ModelsRenderer::UpdateIndirectBuffer()
 {
-  return (uint32_t)objects.size();
+  drawCommands = GetDrawIndexedIndirectCommands(objects);
+
+  drawGroups = {};
+
+  uint32_t command = 0;
+  for (auto obj : objects)
+  {
+    auto& group = drawGroups[(uint32_t)GetVertexFormat(obj)][(uint32_t)GetIndexFormat(obj)];
+
+    if (group.commandCount == 0)
+    {
+      group.firstCommand = command;
+    }
+
+    group.commandCount += obj->GetLodCount();
+    command += obj->GetLodCount();
+  }
+
+  vk::DeviceSize indirectSize = drawCommands.size() * sizeof(vk::DrawIndexedIndirectCommand);
+
+  if (indirectSize == 0)
+  {
+    return;
+  }
+
+  if (indirectBuffer.GetBuffer() && indirectBuffer.GetSize() == indirectSize)
+  {
+    indirectBuffer.CopyToBufferMemory(drawCommands.data(), indirectSize);
+  }
+  else
+  {
+    // the command buffers are recorded again after objects were added, nothing references the old buffer then
+    indirectBuffer.Destroy();
+    indirectBuffer.CreateHostVisible(indirectSize, drawCommands.data(), vk::BufferUsageFlagBits::eIndirectBuffer);
+  }
 }
 
-std::vector<lpe::Vertex> lpe::ModelsRenderer::GetVertices() const
+uint32_t lpe::ModelsRenderer::GetCount() const
 {
-  return vertices;
+  return (uint32_t)drawCommands.size();
 }
 
-std::vector<uint32_t> lpe::ModelsRenderer::GetIndices() const
+lpe::DrawGroup lpe::ModelsRenderer::GetDrawGroup(VertexFormat vertexFormat, IndexFormat indexFormat) const
 {
-  return indices;
+  return drawGroups[(uint32_t)vertexFormat][(uint32_t)indexFormat];
 }
 
-vk::Buffer lpe::ModelsRenderer::GetVertexBuffer()
+vk::Buffer lpe::ModelsRenderer::GetVertexBuffer(VertexFormat format)
 {
-  return vertexBuffer.GetBuffer();
+  return vertexBuffers[(uint32_t)format].GetBuffer();
 }
 
-vk::Buffer lpe::ModelsRenderer::GetIndexBuffer()
+vk::Buffer lpe::ModelsRenderer::GetIndexBuffer(IndexFormat format)
 {
-  return indexBuffer.GetBuffer();
+  return indexBuffers[(uint32_t)format].GetBuffer();
 }
 
 bool lpe::ModelsRenderer::Empty() const
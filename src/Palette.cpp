@@ -0,0 +1,138 @@
+#include "../include/Palette.h"
+#include <algorithm>
+
+uint32_t lpe::Palette::Add(glm::vec3 color)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const glm::vec4 entry = glm::vec4(color, 1.0f);
+
+  auto existing = std::find(std::begin(colors), std::end(colors), entry);
+  if (existing != std::end(colors))
+  {
+    return (uint32_t)(existing - std::begin(colors));
+  }
+
+  if (colors.size() >= MaxColors)
+  {
+    throw std::runtime_error("Palette is full!");
+  }
+
+  colors.push_back(entry);
+  version++;
+
+  return (uint32_t)colors.size() - 1;
+}
+
+bool lpe::Palette::Add(const std::vector<glm::vec3>& colors, std::vector<uint32_t>& indices)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // counts the colors first, so a full palette is left untouched
+  std::vector<glm::vec4> added;
+
+  for (auto color : colors)
+  {
+    const glm::vec4 entry = glm::vec4(color, 1.0f);
+
+    if (std::find(std::begin(this->colors), std::end(this->colors), entry) == std::end(this->colors) &&
+        std::find(std::begin(added), std::end(added), entry) == std::end(added))
+    {
+      added.push_back(entry);
+    }
+  }
+
+  if (this->colors.size() + added.size() > MaxColors)
+  {
+    return false;
+  }
+
+  if (!added.empty())
+  {
+    this->colors.insert(std::end(this->colors), std::begin(added), std::end(added));
+    version++;
+  }
+
+  indices.resize(colors.size());
+
+  for (size_t i = 0; i < colors.size(); ++i)
+  {
+    indices[i] = (uint32_t)(std::find(std::begin(this->colors), std::end(this->colors), glm::vec4(colors[i], 1.0f)) - std::begin(this->colors));
+  }
+
+  return true;
+}
+
+bool lpe::Palette::Find(glm::vec3 color, uint32_t& index)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto existing = std::find(std::begin(colors), std::end(colors), glm::vec4(color, 1.0f));
+  if (existing == std::end(colors))
+  {
+    return false;
+  }
+
+  index = (uint32_t)(existing - std::begin(colors));
+
+  return true;
+}
+
+void lpe::Palette::SetColor(uint32_t index, glm::vec3 color)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (index >= colors.size())
+  {
+    throw std::runtime_error("Palette index out of range!");
+  }
+
+  colors[index] = glm::vec4(color, 1.0f);
+  version++;
+}
+
+bool lpe::Palette::Replace(glm::vec3 from, glm::vec3 to)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  bool replaced = false;
+
+  for (auto& color : colors)
+  {
+    if (color == glm::vec4(from, 1.0f))
+    {
+      color = glm::vec4(to, 1.0f);
+      replaced = true;
+    }
+  }
+
+  if (replaced)
+  {
+    version++;
+  }
+
+  return replaced;
+}
+
+uint32_t lpe::Palette::GetVersion()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  return version;
+}
+
+std::vector<glm::vec4> lpe::Palette::GetColors(uint32_t& version)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  version = this->version;
+
+  return colors;
+}
+
+lpe::Palette& lpe::Palette::Shared()
+{
+  static Palette palette;
+
+  return palette;
+}
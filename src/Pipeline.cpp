@@ -1,11 +1,37 @@
 #include "../include/Pipeline.h"
 #include "../include/Vertex.h"
 
+namespace
+{
+  struct VertexInput
+  {
+    const char* vertexShader;
+    VkBool32 flatShading;   // specialization constant 0 of shaders/base.frag
+    std::vector<vk::VertexInputBindingDescription> bindings;
+    std::vector<vk::VertexInputAttributeDescription> attributes;
+  };
+
+  VertexInput GetVertexInput(lpe::VertexFormat format, lpe::InstanceEncoding encoding)
+  {
+    switch (format)
+    {
+    case lpe::VertexFormat::Packed:
+      return { "shaders/packed.vert.spv", VK_FALSE, lpe::PackedVertex::GetBindingDescription(encoding), lpe::PackedVertex::GetAttributeDescriptions(encoding) };
+    case lpe::VertexFormat::Flat:
+      return { "shaders/flat.vert.spv", VK_TRUE, lpe::FlatVertex::GetBindingDescription(encoding), lpe::FlatVertex::GetAttributeDescriptions(encoding) };
+    case lpe::VertexFormat::Palette:
+      return { "shaders/palette.vert.spv", VK_TRUE, lpe::PaletteVertex::GetBindingDescription(encoding), lpe::PaletteVertex::GetAttributeDescriptions(encoding) };
+    default:
+      return { "shaders/base.vert.spv", VK_FALSE, lpe::Vertex::GetBindingDescription(encoding), lpe::Vertex::GetAttributeDescriptions(encoding) };
+    }
+  }
+}
+
 void lpe::Pipeline::CreateDescriptorPool()
 {
   std::vector<vk::DescriptorPoolSize> poolSizes =
   {
-    {vk::DescriptorType::eUniformBuffer, 1}
+    {vk::DescriptorType::eUniformBuffer, 2}
   };
 
   vk::DescriptorPoolCreateInfo poolInfo = { {}, 2, (uint32_t)poolSizes.size(), poolSizes.data() };
@@ -18,7 +44,8 @@ void lpe::Pipeline::CreateDescriptorSetLayout()
 {
   std::vector<vk::DescriptorSetLayoutBinding> bindings = 
   {
-    { 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex }
+    { 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex },
+    { 1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex }   // Palette
   };
 
   vk::DescriptorSetLayoutCreateInfo layoutInfo = { {}, (uint32_t)bindings.size(), bindings.data() };
@@ -39,9 +66,9 @@ vk::ShaderModule lpe::Pipeline::CreateShaderModule(const std::vector<char>& code
   return shaderModule;
 }
 
-vk::Pipeline lpe::Pipeline::GetPipeline() const
+vk::Pipeline lpe::Pipeline::GetPipeline(VertexFormat format) const
 {
-  return pipeline;
+  return pipelines[(uint32_t)format];
 }
 
 vk::PipelineLayout lpe::Pipeline::GetPipelineLayout() const
@@ -59,24 +86,11 @@ vk::DescriptorSet* lpe::Pipeline::GetDescriptorSetRef()
   return &descriptorSet;
 }
 
-void lpe::Pipeline::CreatePipeline(vk::Extent2D swapChainExtent, vk::RenderPass renderPass)
+void lpe::Pipeline::CreatePipeline(vk::Extent2D swapChainExtent, vk::RenderPass renderPass, InstanceEncoding instanceEncoding)
 {
-  auto vertexShaderCode = lpe::helper::ReadSPIRVFile("shaders/base.vert.spv");
   auto fragmentShaderCode = lpe::helper::ReadSPIRVFile("shaders/base.frag.spv");
-
-  auto vertexShaderModule = CreateShaderModule(vertexShaderCode);
   auto fragmentShaderModule = CreateShaderModule(fragmentShaderCode);
 
-  vk::PipelineShaderStageCreateInfo vertexShaderStageInfo = { {}, vk::ShaderStageFlagBits::eVertex, vertexShaderModule, "main" };
-  vk::PipelineShaderStageCreateInfo fragmentShaderStageInfo = { {}, vk::ShaderStageFlagBits::eFragment, fragmentShaderModule, "main" };
-
-  auto bindingDescriptions = Vertex::GetBindingDescription();
-  auto attributeDescriptions = Vertex::GetAttributeDescriptions();
-
-  std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = { vertexShaderStageInfo, fragmentShaderStageInfo };
-
-  vk::PipelineVertexInputStateCreateInfo vertexInputInfo = { {}, (uint32_t)bindingDescriptions.size(), bindingDescriptions.data(), (uint32_t)attributeDescriptions.size(), attributeDescriptions.data() };
-
   vk::PipelineInputAssemblyStateCreateInfo inputAssembly = { {}, vk::PrimitiveTopology::eTriangleList, VK_FALSE };
 
   vk::Viewport viewport = { 0.f, 0.f, (float)swapChainExtent.width, (float)swapChainExtent.height, 0.0f, 1.0f };
@@ -118,11 +132,34 @@ void lpe::Pipeline::CreatePipeline(vk::Extent2D swapChainExtent, vk::RenderPass
   auto result = device->createPipelineLayout(&pipelineLayoutInfo, nullptr, &pipelineLayout);
   helper::ThrowIfNotSuccess(result, "Failed to create PipelineLayout!");
 
-  vk::GraphicsPipelineCreateInfo pipelineInfo = { {}, (uint32_t)shaderStages.size(), shaderStages.data(), &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, &dynamicState, pipelineLayout, renderPass };
+  // the formats only differ in their vertex input, the vertex shader decoding it and how the fragment shader gets its normal
+  vk::SpecializationMapEntry flatShadingEntry = { 0, 0, sizeof(VkBool32) };
+  vk::SpecializationMapEntry instanceEncodingEntry = { 1, 0, sizeof(uint32_t) };   // shaders/instance.glsl
+
+  for (uint32_t format = 0; format < VertexFormatCount; format++)
+  {
+    auto input = GetVertexInput((VertexFormat)format, instanceEncoding);
+
+    auto vertexShaderCode = lpe::helper::ReadSPIRVFile(input.vertexShader);
+    auto vertexShaderModule = CreateShaderModule(vertexShaderCode);
+
+    vk::SpecializationInfo vertexSpecialization = { 1, &instanceEncodingEntry, sizeof(uint32_t), &instanceEncoding };
+    vk::PipelineShaderStageCreateInfo vertexShaderStageInfo = { {}, vk::ShaderStageFlagBits::eVertex, vertexShaderModule, "main", &vertexSpecialization };
+
+    vk::SpecializationInfo fragmentSpecialization = { 1, &flatShadingEntry, sizeof(VkBool32), &input.flatShading };
+    vk::PipelineShaderStageCreateInfo fragmentShaderStageInfo = { {}, vk::ShaderStageFlagBits::eFragment, fragmentShaderModule, "main", &fragmentSpecialization };
 
-  pipeline = device->createGraphicsPipeline(cache, pipelineInfo);
+    std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = { vertexShaderStageInfo, fragmentShaderStageInfo };
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo = { {}, (uint32_t)input.bindings.size(), input.bindings.data(), (uint32_t)input.attributes.size(), input.attributes.data() };
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo = { {}, (uint32_t)shaderStages.size(), shaderStages.data(), &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, &dynamicState, pipelineLayout, renderPass };
+
+    pipelines[format] = device->createGraphicsPipeline(cache, pipelineInfo);
+
+    device->destroyShaderModule(vertexShaderModule);
+  }
 
-  device->destroyShaderModule(vertexShaderModule);
   device->destroyShaderModule(fragmentShaderModule);
 }
 
@@ -144,7 +181,14 @@ void lpe::Pipeline::UpdateDescriptorSets(std::vector<vk::DescriptorBufferInfo> d
   uboWriteDescriptorSet.descriptorType = vk::DescriptorType::eUniformBuffer;
   uboWriteDescriptorSet.pBufferInfo = &descriptors[0];
 
-  std::vector<vk::WriteDescriptorSet> descriptorWrites = { uboWriteDescriptorSet };
+  // descriptors[1] is the instance buffer, which is bound as a vertex buffer instead
+  vk::WriteDescriptorSet paletteWriteDescriptorSet = { descriptorSet };
+  paletteWriteDescriptorSet.dstBinding = 1;
+  paletteWriteDescriptorSet.descriptorCount = 1;
+  paletteWriteDescriptorSet.descriptorType = vk::DescriptorType::eUniformBuffer;
+  paletteWriteDescriptorSet.pBufferInfo = &descriptors[2];
+
+  std::vector<vk::WriteDescriptorSet> descriptorWrites = { uboWriteDescriptorSet, paletteWriteDescriptorSet };
  
   device->updateDescriptorSets((uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
 }
@@ -157,7 +201,7 @@ void lpe::Pipeline::Copy(const Pipeline& other)
   this->cache = other.cache;
   this->descriptorSetLayout = other.descriptorSetLayout;
   this->pipelineLayout = other.pipelineLayout;
-  this->pipeline = other.pipeline;
+  this->pipelines = other.pipelines;
   this->descriptorPool = other.descriptorPool;
   this->descriptorSet = other.descriptorSet;
 }
@@ -203,7 +247,7 @@ lpe::Pipeline::Pipeline(vk::PhysicalDevice physicalDevice,
 
   CreateDescriptorSetLayout();
 
-  CreatePipeline(swapChainExtent, renderPass);
+  CreatePipeline(swapChainExtent, renderPass, uniformBuffer->GetInstanceEncoding());
 
   CreateDescriptorPool();
 
@@ -224,9 +268,12 @@ lpe::Pipeline::~Pipeline()
       device->destroyPipelineLayout(pipelineLayout);
     }
 
-    if(pipeline)
+    for (auto pipeline : pipelines)
     {
-      device->destroyPipeline(pipeline);
+      if(pipeline)
+      {
+        device->destroyPipeline(pipeline);
+      }
     }
 
     if(descriptorPool)
@@ -0,0 +1,984 @@
+#include "../include/PlyFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+  size_t SizeOf(lpe::PlyType type)
+  {
+    switch (type)
+    {
+    case lpe::PlyType::Int8:
+    case lpe::PlyType::UInt8:
+      return 1;
+    case lpe::PlyType::Int16:
+    case lpe::PlyType::UInt16:
+      return 2;
+    case lpe::PlyType::Int32:
+    case lpe::PlyType::UInt32:
+    case lpe::PlyType::Float32:
+      return 4;
+    case lpe::PlyType::Float64:
+      return 8;
+    default:
+      return 0;
+    }
+  }
+
+  lpe::PlyType ParseType(const std::string& name)
+  {
+    if (name == "char" || name == "int8") return lpe::PlyType::Int8;
+    if (name == "uchar" || name == "uint8") return lpe::PlyType::UInt8;
+    if (name == "short" || name == "int16") return lpe::PlyType::Int16;
+    if (name == "ushort" || name == "uint16") return lpe::PlyType::UInt16;
+    if (name == "int" || name == "int32") return lpe::PlyType::Int32;
+    if (name == "uint" || name == "uint32") return lpe::PlyType::UInt32;
+    if (name == "float" || name == "float32") return lpe::PlyType::Float32;
+    if (name == "double" || name == "float64") return lpe::PlyType::Float64;
+
+    throw std::runtime_error("unknown ply property type \"" + name + "\"");
+  }
+
+  bool IsHostLittleEndian()
+  {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+  }
+
+  template <typename T>
+  T Load(const char* source, bool swap)
+  {
+    char bytes[sizeof(T)];
+
+    if (swap)
+    {
+      for (size_t i = 0; i < sizeof(T); ++i)
+      {
+        bytes[i] = source[sizeof(T) - 1 - i];
+      }
+    }
+    else
+    {
+      memcpy(bytes, source, sizeof(T));
+    }
+
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+
+    return value;
+  }
+
+  double LoadScalar(const char* source, lpe::PlyType type, bool swap)
+  {
+    switch (type)
+    {
+    case lpe::PlyType::Int8: return Load<int8_t>(source, swap);
+    case lpe::PlyType::UInt8: return Load<uint8_t>(source, swap);
+    case lpe::PlyType::Int16: return Load<int16_t>(source, swap);
+    case lpe::PlyType::UInt16: return Load<uint16_t>(source, swap);
+    case lpe::PlyType::Int32: return Load<int32_t>(source, swap);
+    case lpe::PlyType::UInt32: return Load<uint32_t>(source, swap);
+    case lpe::PlyType::Float32: return Load<float>(source, swap);
+    case lpe::PlyType::Float64: return Load<double>(source, swap);
+    default: return 0;
+    }
+  }
+
+  int64_t LoadInteger(const char* source, lpe::PlyType type, bool swap)
+  {
+    switch (type)
+    {
+    case lpe::PlyType::Int8: return Load<int8_t>(source, swap);
+    case lpe::PlyType::UInt8: return Load<uint8_t>(source, swap);
+    case lpe::PlyType::Int16: return Load<int16_t>(source, swap);
+    case lpe::PlyType::UInt16: return Load<uint16_t>(source, swap);
+    case lpe::PlyType::Int32: return Load<int32_t>(source, swap);
+    case lpe::PlyType::UInt32: return Load<uint32_t>(source, swap);
+    case lpe::PlyType::Float32: return (int64_t)Load<float>(source, swap);
+    case lpe::PlyType::Float64: return (int64_t)Load<double>(source, swap);
+    default: return 0;
+    }
+  }
+
+  void Require(const char* cursor, const char* end, size_t bytes)
+  {
+    if ((size_t)(end - cursor) < bytes)
+    {
+      throw std::runtime_error("unexpected end of ply body");
+    }
+  }
+
+  const size_t NoTarget = ~(size_t)0;
+
+  // where a vertex property ends up inside of lpe::Vertex (byte offset of the float)
+  // and the divisor which normalizes integer colors to [0, 1]
+  struct VertexTarget
+  {
+    size_t offset;
+    float divisor;
+  };
+
+  VertexTarget FindVertexTarget(const lpe::PlyProperty& property)
+  {
+    static const char* positions[] = { "x", "y", "z" };
+    static const char* normals[] = { "nx", "ny", "nz" };
+    static const char* colors[] = { "red", "green", "blue" };
+    static const char* shortColors[] = { "r", "g", "b" };
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+      if (property.name == positions[i])
+      {
+        return { offsetof(lpe::Vertex, position) + i * sizeof(float), 1.0f };
+      }
+
+      if (property.name == normals[i])
+      {
+        return { offsetof(lpe::Vertex, normals) + i * sizeof(float), 1.0f };
+      }
+
+      if (property.name == colors[i] || property.name == shortColors[i])
+      {
+        float divisor = 1.0f;
+
+        if (property.type == lpe::PlyType::UInt8)
+        {
+          divisor = 255.0f;
+        }
+        else if (property.type == lpe::PlyType::UInt16)
+        {
+          divisor = 65535.0f;
+        }
+
+        return { offsetof(lpe::Vertex, color) + i * sizeof(float), divisor };
+      }
+    }
+
+    return { NoTarget, 0.0f };
+  }
+
+  std::vector<VertexTarget> FindVertexTargets(const lpe::PlyElement& element, const std::string& fileName)
+  {
+    std::vector<VertexTarget> targets;
+    targets.reserve(element.properties.size());
+
+    for (const auto& property : element.properties)
+    {
+      if (property.countType != lpe::PlyType::None)
+      {
+        throw std::runtime_error("list properties on vertices are not supported (" + fileName + ")");
+      }
+
+      targets.push_back(FindVertexTarget(property));
+    }
+
+    return targets;
+  }
+
+  bool IsIndexList(const lpe::PlyProperty& property)
+  {
+    return property.countType != lpe::PlyType::None && (property.name == "vertex_indices" || property.name == "vertex_index");
+  }
+
+  // size of one item of the element in a binary body, 0 if it contains lists of unknown length
+  // index lists are expected to be triangles, everything else is rejected while reading anyway
+  size_t FixedStride(const lpe::PlyElement& element)
+  {
+    size_t stride = 0;
+
+    for (const auto& property : element.properties)
+    {
+      if (property.countType == lpe::PlyType::None)
+      {
+        stride += SizeOf(property.type);
+      }
+      else if (IsIndexList(property))
+      {
+        stride += SizeOf(property.countType) + 3 * SizeOf(property.type);
+      }
+      else
+      {
+        return 0;
+      }
+    }
+
+    return stride;
+  }
+
+  // smaller chunks cost more in scheduling than they save
+  const uint32_t MinItemsPerChunk = 8192;
+
+  bool IsDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  const char* SkipBlanks(const char* cursor, const char* end)
+  {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+    {
+      ++cursor;
+    }
+
+    return cursor;
+  }
+
+  const char* SkipLine(const char* cursor, const char* end)
+  {
+    const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+
+    return lineEnd ? lineEnd + 1 : end;
+  }
+
+  // replacement for std::stof without the std::string in between
+  // digits beyond the precision of the mantissa are only counted for the exponent
+  const char* ScanFloat(const char* cursor, const char* end, double& value)
+  {
+    static const double powers[] =
+    {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+      1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    cursor = SkipBlanks(cursor, end);
+
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+    {
+      negative = *cursor == '-';
+      ++cursor;
+    }
+
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    bool anyDigit = false;
+
+    while (cursor < end && IsDigit(*cursor))
+    {
+      if (mantissa < 100000000000000000ull)
+      {
+        mantissa = mantissa * 10 + (uint64_t)(*cursor - '0');
+      }
+      else
+      {
+        exponent++;
+      }
+
+      anyDigit = true;
+      ++cursor;
+    }
+
+    if (cursor < end && *cursor == '.')
+    {
+      ++cursor;
+
+      while (cursor < end && IsDigit(*cursor))
+      {
+        if (mantissa < 100000000000000000ull)
+        {
+          mantissa = mantissa * 10 + (uint64_t)(*cursor - '0');
+          exponent--;
+        }
+
+        anyDigit = true;
+        ++cursor;
+      }
+    }
+
+    if (!anyDigit)
+    {
+      throw std::runtime_error("expected a number in ply body");
+    }
+
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+    {
+      ++cursor;
+
+      bool negativeExponent = false;
+      if (cursor < end && (*cursor == '-' || *cursor == '+'))
+      {
+        negativeExponent = *cursor == '-';
+        ++cursor;
+      }
+
+      int32_t explicitExponent = 0;
+      while (cursor < end && IsDigit(*cursor))
+      {
+        if (explicitExponent < 10000)
+        {
+          explicitExponent = explicitExponent * 10 + (*cursor - '0');
+        }
+        ++cursor;
+      }
+
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    double result = (double)mantissa;
+
+    if (exponent < 0 && exponent >= -22)
+    {
+      result /= powers[-exponent];
+    }
+    else if (exponent > 0 && exponent <= 22)
+    {
+      result *= powers[exponent];
+    }
+    else if (exponent != 0)
+    {
+      result *= std::pow(10.0, exponent);
+    }
+
+    value = negative ? -result : result;
+
+    return cursor;
+  }
+
+  const char* ScanInteger(const char* cursor, const char* end, int64_t& value)
+  {
+    cursor = SkipBlanks(cursor, end);
+
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+    {
+      negative = *cursor == '-';
+      ++cursor;
+    }
+
+    if (cursor >= end || !IsDigit(*cursor))
+    {
+      throw std::runtime_error("expected an integer in ply body");
+    }
+
+    int64_t result = 0;
+    while (cursor < end && IsDigit(*cursor))
+    {
+      result = result * 10 + (*cursor - '0');
+      ++cursor;
+    }
+
+    value = negative ? -result : result;
+
+    return cursor;
+  }
+
+  const char* SkipToken(const char* cursor, const char* end)
+  {
+    cursor = SkipBlanks(cursor, end);
+
+    while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '\n')
+    {
+      ++cursor;
+    }
+
+    return cursor;
+  }
+}
+
+lpe::PlyFile::PlyFile(const std::string& fileName)
+  : fileName(fileName),
+    file(fileName),
+    format(PlyFormat::Ascii),
+    bodyOffset(0)
+{
+  ParseHeader();
+}
+
+void lpe::PlyFile::ParseHeader()
+{
+  const char* begin = file.GetData();
+  const char* end = begin + file.GetSize();
+  const char* cursor = begin;
+
+  bool magic = false;
+  bool hasFormat = false;
+
+  while (cursor < end)
+  {
+    const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+    if (!lineEnd)
+    {
+      lineEnd = end;
+    }
+
+    std::string line(cursor, lineEnd);
+    cursor = lineEnd < end ? lineEnd + 1 : end;
+
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+
+    std::istringstream stream(line);
+    std::string keyword;
+    stream >> keyword;
+
+    if (!magic)
+    {
+      if (keyword != "ply")
+      {
+        throw std::runtime_error(fileName + " is not a ply file");
+      }
+
+      magic = true;
+      continue;
+    }
+
+    if (keyword == "format")
+    {
+      std::string name;
+      stream >> name;
+
+      if (name == "ascii")
+      {
+        format = PlyFormat::Ascii;
+      }
+      else if (name == "binary_little_endian")
+      {
+        format = PlyFormat::BinaryLittleEndian;
+      }
+      else if (name == "binary_big_endian")
+      {
+        format = PlyFormat::BinaryBigEndian;
+      }
+      else
+      {
+        throw std::runtime_error("unknown ply format \"" + name + "\" in " + fileName);
+      }
+
+      hasFormat = true;
+    }
+    else if (keyword == "element")
+    {
+      PlyElement element;
+      stream >> element.name >> element.count;
+
+      if (stream.fail())
+      {
+        throw std::runtime_error("invalid element declaration in " + fileName);
+      }
+
+      elements.push_back(element);
+    }
+    else if (keyword == "property")
+    {
+      if (elements.empty())
+      {
+        throw std::runtime_error("property without element in " + fileName);
+      }
+
+      PlyProperty property;
+      std::string type;
+      stream >> type;
+
+      if (type == "list")
+      {
+        std::string countType;
+        std::string itemType;
+        stream >> countType >> itemType >> property.name;
+
+        property.countType = ParseType(countType);
+        property.type = ParseType(itemType);
+      }
+      else
+      {
+        stream >> property.name;
+        property.type = ParseType(type);
+      }
+
+      if (property.name.empty())
+      {
+        throw std::runtime_error("invalid property declaration in " + fileName);
+      }
+
+      elements.back().properties.push_back(property);
+    }
+    else if (keyword == "end_header")
+    {
+      if (!hasFormat)
+      {
+        break;
+      }
+
+      bodyOffset = (size_t)(cursor - begin);
+      return;
+    }
+
+    // comment, obj_info and empty lines are ignored
+  }
+
+  throw std::runtime_error("file doesn't have the right format");
+}
+
+uint32_t lpe::PlyFile::AllocateOutput(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const
+{
+  const PlyElement* vertexElement = nullptr;
+  const PlyElement* faceElement = nullptr;
+
+  for (const auto& element : elements)
+  {
+    if (element.name == "vertex")
+    {
+      vertexElement = &element;
+    }
+    else if (element.name == "face")
+    {
+      faceElement = &element;
+    }
+  }
+
+  if (!vertexElement || !faceElement)
+  {
+    throw std::runtime_error("file doesn't have the right format");
+  }
+
+  vertices.resize(vertexElement->count);
+  indices.resize((size_t)faceElement->count * 3);
+
+  return vertexElement->count;
+}
+
+const char* lpe::PlyFile::ReadElement(const PlyElement& element,
+                                      const char* cursor,
+                                      const char* end,
+                                      uint32_t first,
+                                      uint32_t count,
+                                      uint32_t vertexCount,
+                                      Vertex* vertices,
+                                      uint32_t* indices) const
+{
+  if (format == PlyFormat::Ascii)
+  {
+    if (element.name == "vertex")
+    {
+      return ReadAsciiVertices(element, cursor, end, vertices + first, count);
+    }
+
+    if (element.name == "face")
+    {
+      return ReadAsciiFaces(element, cursor, end, indices + (size_t)first * 3, count, vertexCount);
+    }
+
+    return SkipAsciiElement(element, cursor, end);
+  }
+
+  if (element.name == "vertex")
+  {
+    return ReadBinaryVertices(element, cursor, end, vertices + first, count);
+  }
+
+  if (element.name == "face")
+  {
+    return ReadBinaryFaces(element, cursor, end, indices + (size_t)first * 3, count, vertexCount);
+  }
+
+  return SkipBinaryElement(element, cursor, end);
+}
+
+void lpe::PlyFile::Read(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) const
+{
+  const uint32_t vertexCount = AllocateOutput(vertices, indices);
+
+  const char* cursor = file.GetData() + bodyOffset;
+  const char* end = file.GetData() + file.GetSize();
+
+  for (const auto& element : elements)
+  {
+    cursor = ReadElement(element, cursor, end, 0, element.count, vertexCount, vertices.data(), indices.data());
+  }
+}
+
+void lpe::PlyFile::Read(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, ThreadPool& pool) const
+{
+  struct Chunk
+  {
+    const PlyElement* element;
+    const char* begin;
+    uint32_t first;
+    uint32_t count;
+  };
+
+  const uint32_t vertexCount = AllocateOutput(vertices, indices);
+  const uint32_t chunksPerElement = pool.GetThreadCount() * 4;
+
+  const char* cursor = file.GetData() + bodyOffset;
+  const char* end = file.GetData() + file.GetSize();
+
+  // split the vertex and face sections into chunks which start on an item boundary
+  std::vector<Chunk> chunks;
+
+  for (const auto& element : elements)
+  {
+    const bool parsed = element.name == "vertex" || element.name == "face";
+    const uint32_t itemsPerChunk = std::max(MinItemsPerChunk, (element.count + chunksPerElement - 1) / chunksPerElement);
+
+    if (format == PlyFormat::Ascii)
+    {
+      if (!parsed)
+      {
+        cursor = SkipAsciiElement(element, cursor, end);
+        continue;
+      }
+
+      for (uint32_t first = 0; first < element.count; first += itemsPerChunk)
+      {
+        const uint32_t count = std::min(itemsPerChunk, element.count - first);
+        chunks.push_back({ &element, cursor, first, count });
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+          cursor = SkipLine(cursor, end);
+        }
+      }
+
+      continue;
+    }
+
+    const size_t stride = FixedStride(element);
+
+    if (stride == 0)
+    {
+      // variable sized items have to be walked one after another anyway
+      cursor = ReadElement(element, cursor, end, 0, element.count, vertexCount, vertices.data(), indices.data());
+      continue;
+    }
+
+    Require(cursor, end, stride * element.count);
+
+    if (parsed)
+    {
+      for (uint32_t first = 0; first < element.count; first += itemsPerChunk)
+      {
+        chunks.push_back({ &element, cursor + stride * first, first, std::min(itemsPerChunk, element.count - first) });
+      }
+    }
+
+    cursor += stride * element.count;
+  }
+
+  if (chunks.size() <= 1)
+  {
+    for (const auto& chunk : chunks)
+    {
+      ReadElement(*chunk.element, chunk.begin, end, chunk.first, chunk.count, vertexCount, vertices.data(), indices.data());
+    }
+
+    return;
+  }
+
+  Vertex* vertexData = vertices.data();
+  uint32_t* indexData = indices.data();
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(chunks.size());
+
+  for (const auto& chunk : chunks)
+  {
+    futures.push_back(pool.Enqueue([this, chunk, end, vertexCount, vertexData, indexData]()
+    {
+      ReadElement(*chunk.element, chunk.begin, end, chunk.first, chunk.count, vertexCount, vertexData, indexData);
+    }));
+  }
+
+  // every chunk has to be finished before the output may go out of scope, even if one of them failed
+  std::exception_ptr error;
+
+  for (auto& future : futures)
+  {
+    try
+    {
+      pool.Wait(future);
+    }
+    catch (...)
+    {
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+    }
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+const char* lpe::PlyFile::ReadBinaryVertices(const PlyElement& element,
+                                             const char* cursor,
+                                             const char* end,
+                                             Vertex* vertices,
+                                             uint32_t count) const
+{
+  const bool swap = (format == PlyFormat::BinaryBigEndian) == IsHostLittleEndian();
+
+  auto targets = FindVertexTargets(element, fileName);
+
+  Require(cursor, end, FixedStride(element) * count);
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    Vertex vertex{};
+    char* destination = reinterpret_cast<char*>(&vertex);
+
+    for (size_t p = 0; p < element.properties.size(); ++p)
+    {
+      const auto& property = element.properties[p];
+      const auto& target = targets[p];
+
+      if (target.offset != NoTarget)
+      {
+        float value;
+
+        if (property.type == PlyType::Float32)
+        {
+          value = Load<float>(cursor, swap);
+        }
+        else
+        {
+          value = (float)LoadScalar(cursor, property.type, swap) / target.divisor;
+        }
+
+        memcpy(destination + target.offset, &value, sizeof(float));
+      }
+
+      cursor += SizeOf(property.type);
+    }
+
+    vertices[i] = vertex;
+  }
+
+  return cursor;
+}
+
+const char* lpe::PlyFile::ReadBinaryFaces(const PlyElement& element,
+                                          const char* cursor,
+                                          const char* end,
+                                          uint32_t* indices,
+                                          uint32_t count,
+                                          uint32_t vertexCount) const
+{
+  const bool swap = (format == PlyFormat::BinaryBigEndian) == IsHostLittleEndian();
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    for (const auto& property : element.properties)
+    {
+      const size_t size = SizeOf(property.type);
+
+      if (property.countType == PlyType::None)
+      {
+        Require(cursor, end, size);
+        cursor += size;
+        continue;
+      }
+
+      const size_t countSize = SizeOf(property.countType);
+      Require(cursor, end, countSize);
+
+      int64_t listLength = LoadInteger(cursor, property.countType, swap);
+      cursor += countSize;
+
+      if (listLength < 0)
+      {
+        throw std::runtime_error("negative list length in " + fileName);
+      }
+
+      Require(cursor, end, size * (size_t)listLength);
+
+      if (!IsIndexList(property))
+      {
+        cursor += size * (size_t)listLength;
+        continue;
+      }
+
+      if (listLength != 3)
+      {
+        throw std::runtime_error("faces are not triangulated!");
+      }
+
+      for (size_t k = 0; k < 3; ++k)
+      {
+        int64_t index = LoadInteger(cursor, property.type, swap);
+        cursor += size;
+
+        if (index < 0 || index >= vertexCount)
+        {
+          throw std::runtime_error("face index out of range in " + fileName);
+        }
+
+        indices[(size_t)i * 3 + k] = (uint32_t)index;
+      }
+    }
+  }
+
+  return cursor;
+}
+
+const char* lpe::PlyFile::SkipBinaryElement(const PlyElement& element, const char* cursor, const char* end) const
+{
+  const bool swap = (format == PlyFormat::BinaryBigEndian) == IsHostLittleEndian();
+
+  for (uint32_t i = 0; i < element.count; ++i)
+  {
+    for (const auto& property : element.properties)
+    {
+      const size_t size = SizeOf(property.type);
+
+      if (property.countType == PlyType::None)
+      {
+        Require(cursor, end, size);
+        cursor += size;
+        continue;
+      }
+
+      const size_t countSize = SizeOf(property.countType);
+      Require(cursor, end, countSize);
+
+      int64_t listLength = LoadInteger(cursor, property.countType, swap);
+      cursor += countSize;
+
+      if (listLength < 0)
+      {
+        throw std::runtime_error("negative list length in " + fileName);
+      }
+
+      Require(cursor, end, size * (size_t)listLength);
+      cursor += size * (size_t)listLength;
+    }
+  }
+
+  return cursor;
+}
+
+const char* lpe::PlyFile::ReadAsciiVertices(const PlyElement& element,
+                                            const char* cursor,
+                                            const char* end,
+                                            Vertex* vertices,
+                                            uint32_t count) const
+{
+  auto targets = FindVertexTargets(element, fileName);
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (cursor >= end)
+    {
+      throw std::runtime_error("unexpected end of ply body");
+    }
+
+    Vertex vertex{};
+    char* destination = reinterpret_cast<char*>(&vertex);
+
+    for (const auto& target : targets)
+    {
+      if (target.offset == NoTarget)
+      {
+        cursor = SkipToken(cursor, end);
+        continue;
+      }
+
+      double value;
+      cursor = ScanFloat(cursor, end, value);
+
+      float result = (float)value / target.divisor;
+      memcpy(destination + target.offset, &result, sizeof(float));
+    }
+
+    vertices[i] = vertex;
+    cursor = SkipLine(cursor, end);
+  }
+
+  return cursor;
+}
+
+const char* lpe::PlyFile::ReadAsciiFaces(const PlyElement& element,
+                                         const char* cursor,
+                                         const char* end,
+                                         uint32_t* indices,
+                                         uint32_t count,
+                                         uint32_t vertexCount) const
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (cursor >= end)
+    {
+      throw std::runtime_error("unexpected end of ply body");
+    }
+
+    for (const auto& property : element.properties)
+    {
+      if (property.countType == PlyType::None)
+      {
+        cursor = SkipToken(cursor, end);
+        continue;
+      }
+
+      int64_t listLength;
+      cursor = ScanInteger(cursor, end, listLength);
+
+      if (listLength < 0)
+      {
+        throw std::runtime_error("negative list length in " + fileName);
+      }
+
+      if (!IsIndexList(property))
+      {
+        for (int64_t k = 0; k < listLength; ++k)
+        {
+          cursor = SkipToken(cursor, end);
+        }
+        continue;
+      }
+
+      if (listLength != 3)
+      {
+        throw std::runtime_error("faces are not triangulated!");
+      }
+
+      for (size_t k = 0; k < 3; ++k)
+      {
+        int64_t index;
+        cursor = ScanInteger(cursor, end, index);
+
+        if (index < 0 || index >= vertexCount)
+        {
+          throw std::runtime_error("face index out of range in " + fileName);
+        }
+
+        indices[(size_t)i * 3 + k] = (uint32_t)index;
+      }
+    }
+
+    cursor = SkipLine(cursor, end);
+  }
+
+  return cursor;
+}
+
+const char* lpe::PlyFile::SkipAsciiElement(const PlyElement& element, const char* cursor, const char* end) const
+{
+  for (uint32_t i = 0; i < element.count; ++i)
+  {
+    cursor = SkipLine(cursor, end);
+  }
+
+  return cursor;
+}
+
+lpe::PlyFormat lpe::PlyFile::GetFormat() const
+{
+  return format;
+}
+
+bool lpe::PlyFile::IsBinary() const
+{
+  return format != PlyFormat::Ascii;
+}
+
+const std::vector<lpe::PlyElement>& lpe::PlyFile::GetElements() const
+{
+  return elements;
+}
@@ -1,219 +1,65 @@
 #include "../include/RenderObject.h"
-#include <glm/gtx/transform.hpp>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
 
-lpe::RenderInstance::RenderInstance()
+lpe::InstanceRef::InstanceRef(InstanceStorage* storage, InstanceHandle handle)
+  : storage(storage),
+    handle(handle)
 {
-  values.push({ });
-  ResetTransform();
 }
 
-lpe::RenderInstance::RenderInstance(RenderInstance&& other)
+void lpe::InstanceRef::SetTransform(glm::mat4 transform)
 {
-  values = std::move(other.values);
+  storage->SetTransform(handle, transform);
 }
 
-lpe::RenderInstance::RenderInstance(const RenderInstance& other)
+glm::mat4 lpe::InstanceRef::Transform(glm::mat4 transform)
 {
-  values = { other.values };
+  return storage->Transform(handle, transform);
 }
 
-lpe::RenderInstance& lpe::RenderInstance::operator=(const RenderInstance& other)
+void lpe::InstanceRef::SetPosition(glm::vec3 pos)
 {
-  values = { other.values };
-
-  return *this;
-}
-
-lpe::RenderInstance& lpe::RenderInstance::operator=(RenderInstance&& other)
-{
-  values = std::move(other.values);
-
-  return *this;
-}
-
-lpe::InstanceData lpe::RenderInstance::ToInstanceData()
-{
-  auto position = values.top().position;
-  auto transform = values.top().matrix;
-
-  InstanceData instanceData;
-
-  glm::mat4 matrix = glm::translate(glm::mat4(1.0f), position);
-  matrix = matrix * transform;
-
-  instanceData.row1 = matrix[0];
-  instanceData.row2 = matrix[1];
-  instanceData.row3 = matrix[2];
-  instanceData.row4 = matrix[3];
-
-  return instanceData;
+  storage->SetPosition(handle, pos);
 }
 
-void lpe::RenderInstance::ResetTransform()
+void lpe::InstanceRef::Move(glm::vec3 delta)
 {
-  values.top().matrix = glm::mat4(1.0f);
-  values.top().position = glm::vec3(0);
+  storage->Move(handle, delta);
 }
 
-void lpe::RenderInstance::SetTransform(glm::mat4 transform)
+void lpe::InstanceRef::SetVisible(bool visible)
 {
-  values.top().matrix = transform;
+  storage->SetVisible(handle, visible);
 }
 
-glm::mat4 lpe::RenderInstance::Transform(glm::mat4 transform)
+void lpe::InstanceRef::SetStatic(bool isStatic)
 {
-  auto matrix = values.top().matrix;
-  matrix = matrix * transform;
-  values.top().matrix = matrix;
-
-  return matrix;
+  storage->SetStatic(handle, isStatic);
 }
 
-void lpe::RenderInstance::SetPosition(glm::vec3 pos)
+glm::vec3 lpe::InstanceRef::GetPosition() const
 {
-  values.top().position = pos;
+  return storage->GetPosition(handle);
 }
 
-void lpe::RenderInstance::Move(glm::vec3 delta)
+glm::mat4 lpe::InstanceRef::GetTransform() const
 {
-  values.top().position += delta;
+  return storage->GetTransform(handle);
 }
 
-void lpe::RenderInstance::Push()
+bool lpe::InstanceRef::IsVisible() const
 {
-  values.push({});
-  ResetTransform();
+  return storage->IsVisible(handle);
 }
 
-void lpe::RenderInstance::Pop()
+bool lpe::InstanceRef::IsStatic() const
 {
-  if(values.size() > 1)
-  {
-    values.pop();
-  }
+  return storage->IsStatic(handle);
 }
 
-glm::vec3 lpe::RenderInstance::GetPosition() const
+lpe::InstanceHandle lpe::InstanceRef::GetHandle() const
 {
-  return values.top().position;
-}
-
-glm::mat4 lpe::RenderInstance::GetTransform() const
-{
-  return values.top().matrix;
-}
-
-void lpe::RenderObject::Load(std::string fileName)
-{
-  // simply load ply file
-  // ignoring header!
-
-  std::ifstream file(fileName);
-
-  if (!file)
-  {
-    std::runtime_error("Failed to open model " + fileName);
-  }
-
-  std::string line;
-  bool header = true;
-  uint32_t countVertices = ~0u;
-  uint32_t countFaces = ~0u;
-
-  while (std::getline(file, line))
-  {
-    if (header)
-    {
-      int32_t find = (int32_t)line.find("element vertex");
-      if (find >= 0)
-      {
-        countVertices = std::stoi(line.substr(line.find_last_of(" ") + 1));
-        continue;
-      }
-
-      find = (int32_t)line.find("element face");
-      if (find >= 0)
-      {
-        countFaces = std::stoi(line.substr(line.find_last_of(" ") + 1));
-        continue;
-      }
-
-      if (line == "end_header")
-      {
-        header = false;
-        break;
-      }
-    }
-  }
-
-  if (header || countVertices == -1 || countFaces == -1)
-  {
-    throw std::runtime_error("file doesn't have the right format");
-  }
-
-  vertices.resize(countVertices);
-  for (uint32_t i = 0; i < countVertices; i++)
-  {
-    std::getline(file, line);
-
-    std::istringstream linepart(line);
-    std::string part;
-    uint16_t index = 0;
-    Vertex v;
-
-    while (std::getline(linepart, part, ' '))
-    {
-      if (index <= 2)
-      {
-        v.position[index] = std::stof(part);
-      }
-      else if (index <= 5)
-      {
-        v.normals[index % 3] = std::stof(part);
-      }
-      else if (index <= 8)
-      {
-        v.color[index % 3] = std::stof(part) / 255.f;
-      }
-      else
-      {
-        break;
-      }
-      index++;
-    }
-
-    vertices[i] = v;
-  }
-
-  indices.resize(countFaces * 3);
-  for (uint32_t i = 0; i < countFaces; i++)
-  {
-    std::getline(file, line);
-
-    std::istringstream linepart(line);
-    std::string part;
-    uint16_t index = 0;
-
-    while (std::getline(linepart, part, ' '))
-    {
-      if (index == 0 && std::stoi(part) != 3)
-      {
-        throw std::runtime_error("faces are not triangulated!");
-      }
-
-      if (index > 0)
-      {
-        indices[(i * 3 + index - 1)] = std::stoi(part);
-      }
-
-      index++;
-    }
-  }
-
-  file.close();
+  return handle;
 }
 
 lpe::RenderObject::RenderObject(const RenderObject& other)
@@ -222,9 +68,9 @@ lpe::RenderObject::RenderObject(const RenderObject& other)
   vertexOffset = other.vertexOffset;
   indexOffset = other.indexOffset;
 
-  instances = { other.instances };
-  indices = { other.indices };
-  vertices = { other.vertices };
+  instances = other.instances;
+  mesh = other.mesh;
+  pendingMesh = other.pendingMesh;
 }
 
 lpe::RenderObject::RenderObject(RenderObject&& other) noexcept
@@ -234,8 +80,8 @@ lpe::RenderObject::RenderObject(RenderObject&& other) noexcept
   indexOffset = other.indexOffset;
 
   instances = std::move(other.instances);
-  indices = std::move(other.indices);
-  vertices = std::move(other.vertices);
+  mesh = std::move(other.mesh);
+  pendingMesh = std::move(other.pendingMesh);
 }
 
 lpe::RenderObject& lpe::RenderObject::operator=(const RenderObject& other)
@@ -244,9 +90,9 @@ lpe::RenderObject& lpe::RenderObject::operator=(const RenderObject& other)
   vertexOffset = other.vertexOffset;
   indexOffset = other.indexOffset;
 
-  instances = { other.instances };
-  indices = { other.indices };
-  vertices = { other.vertices };
+  instances = other.instances;
+  mesh = other.mesh;
+  pendingMesh = other.pendingMesh;
 
   return *this;
 }
@@ -258,90 +104,107 @@ lpe::RenderObject& lpe::RenderObject::operator=(RenderObject&& other) noexcept
   indexOffset = other.indexOffset;
 
   instances = std::move(other.instances);
-  indices = std::move(other.indices);
-  vertices = std::move(other.vertices);
+  mesh = std::move(other.mesh);
+  pendingMesh = std::move(other.pendingMesh);
 
   return *this;
 }
 
-lpe::RenderObject::RenderObject(std::string path, uint32_t prio)
+lpe::RenderObject::RenderObject(std::string path, uint32_t prio, LoadMode mode, MeshOptions options)
   : prio(prio)
 {
-  Load(path);
+  if (mode == LoadMode::Async)
+  {
+    pendingMesh = MeshRegistry::Shared().GetAsync(path, options);
+  }
+  else
+  {
+    mesh = MeshRegistry::Shared().Get(path, options);
+  }
 }
 
-void lpe::RenderObject::SetOffsets(uint32_t indexOffset, int32_t vertexOffset)
+lpe::RenderObject::RenderObject(std::shared_ptr<const Mesh> mesh, uint32_t prio)
+  : prio(prio),
+    mesh(std::move(mesh))
 {
-  this->indexOffset = indexOffset;
-  this->vertexOffset = vertexOffset;
 }
 
-lpe::InstanceRef lpe::RenderObject::GetInstance(uint32_t id)
+bool lpe::RenderObject::IsLoaded()
 {
-  auto result = instances.find(id);
-
-  if (result == instances.end())
+  if (!mesh && pendingMesh.valid() && pendingMesh.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
   {
-    instances.insert(std::make_pair(id, RenderInstance{}));
+    auto loaded = pendingMesh;
+    pendingMesh = {};
+
+    mesh = loaded.get();
   }
 
-  auto returnRef = InstanceRef(&instances.at(id));
-  
-  return returnRef;
+  return static_cast<bool>(mesh);
 }
 
-void lpe::RenderObject::EreaseInstance(uint32_t id)
+void lpe::RenderObject::SetOffsets(uint32_t indexOffset, int32_t vertexOffset)
 {
-  instances.erase(id);
+  this->indexOffset = indexOffset;
+  this->vertexOffset = vertexOffset;
 }
 
-vk::DrawIndexedIndirectCommand lpe::RenderObject::GetIndirectCommand(uint32_t existingInstances) const
+lpe::InstanceHandle lpe::RenderObject::AddInstance()
 {
-  vk::DrawIndexedIndirectCommand cmd = { (uint32_t)indices.size(), (uint32_t)instances.size(), indexOffset, vertexOffset, existingInstances };
+  return instances.Add();
+}
 
-  return cmd;
+void lpe::RenderObject::AddInstances(uint32_t count, std::vector<InstanceHandle>& handles)
+{
+  instances.Add(count, handles);
 }
 
-std::vector<lpe::InstanceData> lpe::RenderObject::GetInstanceData()
+void lpe::RenderObject::RemoveInstance(InstanceHandle handle)
 {
-  std::vector<lpe::InstanceData> data(instances.size());
+  instances.Remove(handle);
+}
 
-  for (uint32_t i = 0; i < data.size(); ++i)
-  {
-    auto iterator = instances.begin();
+lpe::InstanceRef lpe::RenderObject::GetInstance(InstanceHandle handle)
+{
+  return { &instances, handle };
+}
 
-    for (uint32_t j = 0; j < i; ++j)
-    {
-      ++iterator;
-    }
+lpe::InstanceStorage& lpe::RenderObject::GetInstances()
+{
+  return instances;
+}
 
-    data[i] = (*iterator).second.ToInstanceData();
+vk::DrawIndexedIndirectCommand lpe::RenderObject::GetIndirectCommand(uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) const
+{
+  uint32_t indexCount = 0;
+  uint32_t lodOffset = 0;
+
+  if (mesh && lod < mesh->lods.size())
+  {
+    indexCount = mesh->lods[lod].indexCount;
+    lodOffset = mesh->lods[lod].indexOffset;
   }
 
-  return data;
-}
+  vk::DrawIndexedIndirectCommand cmd = { indexCount, instanceCount, indexOffset + lodOffset, vertexOffset, firstInstance };
 
-uint32_t lpe::RenderObject::GetInstanceCount() const
-{
-  return  (uint32_t)instances.size();
+  return cmd;
 }
 
-std::vector<lpe::Vertex>::iterator lpe::RenderObject::GetVertexBegin()
+void lpe::RenderObject::GetInstanceData(std::vector<InstanceData>& instanceData, std::vector<AnimationData>& animationData) const
 {
-  return std::begin(vertices);
+  instances.Pack(instanceData, animationData);
 }
 
-std::vector<lpe::Vertex>::iterator lpe::RenderObject::GetVertexEnd()
+uint32_t lpe::RenderObject::GetInstanceCount() const
 {
-  return std::end(vertices);
+  return instances.GetStreamedCount();
 }
 
-std::vector<uint32_t>::iterator lpe::RenderObject::GetIndexBegin()
+uint32_t lpe::RenderObject::GetLodCount() const
 {
-  return std::begin(indices);
+  return mesh && !mesh->lods.empty() ? (uint32_t)mesh->lods.size() : 1;
 }
 
-std::vector<uint32_t>::iterator lpe::RenderObject::GetIndexEnd()
+std::shared_ptr<const lpe::Mesh> lpe::RenderObject::GetMesh() const
 {
-  return std::end(indices);
+  return mesh;
 }
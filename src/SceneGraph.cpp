@@ -0,0 +1,249 @@
+#include "../include/SceneGraph.h"
+#include <algorithm>
+
+const uint32_t lpe::SceneGraph::None;
+
+uint32_t lpe::SceneGraph::GetLinear(SceneNode node) const
+{
+  if (!IsValid(node))
+  {
+    throw std::runtime_error("Invalid scene node!");
+  }
+
+  return slots[node.slot].linear;
+}
+
+void lpe::SceneGraph::Linearize()
+{
+  std::vector<uint32_t> order;
+  order.reserve(slotOfLinear.size());
+
+  for (uint32_t slot = 0; slot < slots.size(); ++slot)
+  {
+    if (slots[slot].alive && slots[slot].parent == None)
+    {
+      order.push_back(slot);
+    }
+  }
+
+  std::vector<glm::mat4> sortedLocals;
+  std::vector<InstanceStorage*> sortedStorages;
+  std::vector<InstanceHandle> sortedInstances;
+
+  sortedLocals.reserve(order.size());
+  parents.assign(order.size(), None);
+  firstChildren.clear();
+  childCounts.clear();
+
+  // order grows while it is walked, the children of each node are appended in one go
+  for (uint32_t linear = 0; linear < order.size(); ++linear)
+  {
+    auto& slot = slots[order[linear]];
+    const uint32_t old = slot.linear;
+
+    sortedLocals.push_back(locals[old]);
+    sortedStorages.push_back(storages[old]);
+    sortedInstances.push_back(instances[old]);
+
+    firstChildren.push_back((uint32_t)order.size());
+    childCounts.push_back((uint32_t)slot.children.size());
+
+    for (auto child : slot.children)
+    {
+      order.push_back(child);
+      parents.push_back(linear);
+    }
+
+    slot.linear = linear;
+  }
+
+  locals = std::move(sortedLocals);
+  storages = std::move(sortedStorages);
+  instances = std::move(sortedInstances);
+  slotOfLinear = std::move(order);
+
+  worlds.resize(locals.size());
+  updated.assign(locals.size(), updateCount);
+
+  // every node moved, so all of them are recomputed once
+  dirty.clear();
+  for (uint32_t linear = 0; linear < locals.size() && parents[linear] == None; ++linear)
+  {
+    dirty.push_back(linear);
+  }
+
+  structureChanged = false;
+}
+
+lpe::SceneNode lpe::SceneGraph::Add(SceneNode parent)
+{
+  const bool hasParent = IsValid(parent);
+
+  uint32_t slot;
+
+  if (freeSlots.empty())
+  {
+    slot = (uint32_t)slots.size();
+    slots.push_back({});
+  }
+  else
+  {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  }
+
+  auto& entry = slots[slot];
+  entry.linear = (uint32_t)locals.size();
+  entry.parent = hasParent ? parent.slot : None;
+  entry.children.clear();
+  entry.alive = true;
+
+  if (hasParent)
+  {
+    slots[parent.slot].children.push_back(slot);
+  }
+
+  locals.push_back(glm::mat4(1.0f));
+  worlds.push_back(glm::mat4(1.0f));
+  parents.push_back(None);
+  firstChildren.push_back(0);
+  childCounts.push_back(0);
+  storages.push_back(nullptr);
+  instances.push_back({});
+  slotOfLinear.push_back(slot);
+  updated.push_back(updateCount);
+
+  structureChanged = true;
+
+  return { slot, entry.generation };
+}
+
+void lpe::SceneGraph::Remove(SceneNode node)
+{
+  if (!IsValid(node))
+  {
+    return;
+  }
+
+  const uint32_t parent = slots[node.slot].parent;
+  if (parent != None)
+  {
+    auto& siblings = slots[parent].children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node.slot));
+  }
+
+  std::vector<uint32_t> removed = { node.slot };
+
+  while (!removed.empty())
+  {
+    const uint32_t slot = removed.back();
+    removed.pop_back();
+
+    auto& entry = slots[slot];
+    removed.insert(removed.end(), entry.children.begin(), entry.children.end());
+
+    entry.children.clear();
+    entry.alive = false;
+    entry.generation++;
+    freeSlots.push_back(slot);
+  }
+
+  structureChanged = true;
+}
+
+bool lpe::SceneGraph::IsValid(SceneNode node) const
+{
+  return node.slot < slots.size() && slots[node.slot].alive && slots[node.slot].generation == node.generation;
+}
+
+void lpe::SceneGraph::SetLocal(SceneNode node, const glm::mat4& local)
+{
+  const uint32_t linear = GetLinear(node);
+
+  locals[linear] = local;
+  dirty.push_back(linear);
+}
+
+glm::mat4 lpe::SceneGraph::GetLocal(SceneNode node) const
+{
+  return locals[GetLinear(node)];
+}
+
+glm::mat4 lpe::SceneGraph::GetWorld(SceneNode node) const
+{
+  return worlds[GetLinear(node)];
+}
+
+void lpe::SceneGraph::Attach(SceneNode node, InstanceStorage& storage, InstanceHandle instance)
+{
+  const uint32_t linear = GetLinear(node);
+
+  storages[linear] = &storage;
+  instances[linear] = instance;
+
+  storage.SetPosition(instance, glm::vec3(0.0f));
+  dirty.push_back(linear);
+}
+
+void lpe::SceneGraph::Detach(SceneNode node)
+{
+  const uint32_t linear = GetLinear(node);
+
+  storages[linear] = nullptr;
+  instances[linear] = {};
+}
+
+void lpe::SceneGraph::Update()
+{
+  if (structureChanged)
+  {
+    Linearize();
+  }
+
+  if (dirty.empty())
+  {
+    return;
+  }
+
+  updateCount++;
+
+  // parents come first, so a node which is below another changed node is already done when it comes up
+  std::sort(dirty.begin(), dirty.end());
+
+  for (auto root : dirty)
+  {
+    if (updated[root] == updateCount)
+    {
+      continue;
+    }
+
+    pending.push_back(root);
+
+    while (!pending.empty())
+    {
+      const uint32_t linear = pending.back();
+      pending.pop_back();
+
+      const uint32_t parent = parents[linear];
+      worlds[linear] = parent == None ? locals[linear] : worlds[parent] * locals[linear];
+      updated[linear] = updateCount;
+
+      if (storages[linear] && storages[linear]->IsValid(instances[linear]))
+      {
+        storages[linear]->SetTransform(instances[linear], worlds[linear]);
+      }
+
+      for (uint32_t child = firstChildren[linear]; child < firstChildren[linear] + childCounts[linear]; ++child)
+      {
+        pending.push_back(child);
+      }
+    }
+  }
+
+  dirty.clear();
+}
+
+uint32_t lpe::SceneGraph::GetCount() const
+{
+  return (uint32_t)(slots.size() - freeSlots.size());
+}
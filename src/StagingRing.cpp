@@ -0,0 +1,277 @@
+#include "../include/StagingRing.h"
+#include <algorithm>
+
+const uint32_t lpe::StagingRing::FrameCount;
+const vk::DeviceSize lpe::StagingRing::DefaultSize;
+const vk::DeviceSize lpe::StagingRing::Alignment;
+
+lpe::StagingRing::StagingRing(vk::PhysicalDevice physicalDevice, vk::Device* device, vk::Queue* queue, vk::CommandPool commandPool, vk::DeviceSize size)
+  : commandPool(commandPool),
+    size(size)
+{
+  this->device.reset(device);
+  this->queue.reset(queue);
+
+  buffer = { physicalDevice, device, size, vk::BufferUsageFlagBits::eTransferSrc };
+
+  vk::CommandBufferAllocateInfo allocInfo = { commandPool, vk::CommandBufferLevel::ePrimary, FrameCount };
+  auto commandBuffers = this->device->allocateCommandBuffers(allocInfo);
+
+  for (uint32_t i = 0; i < FrameCount; ++i)
+  {
+    frames[i].commandBuffer = commandBuffers[i];
+
+    vk::FenceCreateInfo fenceCreateInfo = {};
+    auto result = this->device->createFence(&fenceCreateInfo, nullptr, &frames[i].fence);
+    helper::ThrowIfNotSuccess(result, "Failed to create Fence");
+  }
+}
+
+lpe::StagingRing::~StagingRing()
+{
+  if (device)
+  {
+    for (auto& frame : frames)
+    {
+      if (frame.pending)
+      {
+        device->waitForFences(1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+      }
+
+      if (frame.fence)
+      {
+        device->destroyFence(frame.fence);
+      }
+
+      if (frame.commandBuffer)
+      {
+        device->freeCommandBuffers(commandPool, 1, &frame.commandBuffer);
+      }
+    }
+
+    buffer.Destroy();
+
+    device.release();
+  }
+
+  if (queue)
+  {
+    queue.release();
+  }
+}
+
+void lpe::StagingRing::Begin()
+{
+  if (recording)
+  {
+    return;
+  }
+
+  // the frame was submitted FrameCount submissions ago, usually it's done already
+  auto& frame = frames[current];
+
+  while (frame.pending)
+  {
+    RetireOldest(true);
+  }
+
+  auto result = device->resetFences(1, &frame.fence);
+  helper::ThrowIfNotSuccess(result, "Failed to reset Fence");
+
+  vk::CommandBufferBeginInfo beginInfo = { vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
+  frame.commandBuffer.begin(beginInfo);
+
+  recording = true;
+}
+
+void lpe::StagingRing::RecordCopies()
+{
+  if (!copies.empty())
+  {
+    copyTarget->Copy(buffer, frames[current].commandBuffer, copies);
+    copies.clear();
+  }
+}
+
+bool lpe::StagingRing::RetireOldest(bool wait)
+{
+  for (uint32_t i = 0; i < FrameCount; ++i)
+  {
+    auto& frame = frames[(current + i) % FrameCount];
+
+    if (!frame.pending)
+    {
+      continue;
+    }
+
+    auto result = device->getFenceStatus(frame.fence);
+
+    if (result == vk::Result::eNotReady)
+    {
+      if (!wait)
+      {
+        return false;
+      }
+
+      result = device->waitForFences(1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+
+    helper::ThrowIfNotSuccess(result, "Failed to wait for Fences");
+
+    tail = frame.end;
+    frame.pending = false;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool lpe::StagingRing::Allocate(vk::DeviceSize bytes, vk::DeviceSize& offset)
+{
+  if (head == tail)
+  {
+    // nothing is in flight, starting over at the beginning leaves the whole ring for the next range
+    head = tail = (head + size - 1) / size * size;
+  }
+
+  const vk::DeviceSize position = head % size;
+  vk::DeviceSize start = (position + Alignment - 1) / Alignment * Alignment;
+
+  // ranges never wrap around, the rest of the ring is skipped instead
+  if (start + bytes > size)
+  {
+    start = size;
+  }
+
+  const vk::DeviceSize used = start - position + bytes;
+
+  if (head + used - tail > size)
+  {
+    return false;
+  }
+
+  offset = start % size;
+  head += used;
+
+  return true;
+}
+
+vk::DeviceSize lpe::StagingRing::Stage(const uint8_t* data, vk::DeviceSize bytes)
+{
+  vk::DeviceSize offset;
+
+  while (!Allocate(bytes, offset))
+  {
+    if (RetireOldest(true))
+    {
+      continue;
+    }
+
+    if (head == tail)
+    {
+      throw std::runtime_error("Upload doesn't fit into the staging ring!");
+    }
+
+    // the ring is full of this frame's uploads
+    Flush();
+    Begin();
+  }
+
+  memcpy(static_cast<uint8_t*>(buffer.GetMemory().mapped) + offset, data, (size_t)bytes);
+
+  return offset;
+}
+
+vk::CommandBuffer lpe::StagingRing::GetCommandBuffer()
+{
+  Begin();
+  RecordCopies();
+
+  return frames[current].commandBuffer;
+}
+
+void lpe::StagingRing::Upload(Buffer& target, const void* data, const std::vector<vk::BufferCopy>& regions)
+{
+  auto bytes = static_cast<const uint8_t*>(data);
+
+  Begin();
+
+  if (copyTarget != &target)
+  {
+    RecordCopies();
+    copyTarget = &target;
+  }
+
+  for (const auto& region : regions)
+  {
+    for (vk::DeviceSize done = 0; done < region.size;)
+    {
+      const vk::DeviceSize piece = std::min(region.size - done, size);
+      const vk::DeviceSize offset = Stage(bytes + region.srcOffset + done, piece);
+
+      // Stage may have submitted the copies recorded so far
+      copyTarget = &target;
+      copies.push_back({ offset, region.dstOffset + done, piece });
+
+      done += piece;
+    }
+  }
+}
+
+void lpe::StagingRing::Upload(Buffer& target, const void* data, vk::DeviceSize size)
+{
+  Upload(target, data, { { 0, 0, size } });
+}
+
+void lpe::StagingRing::Submit()
+{
+  if (!recording)
+  {
+    return;
+  }
+
+  auto& frame = frames[current];
+
+  RecordCopies();
+
+  // submission order extends the barrier to the command buffers which draw with the uploaded data
+  vk::MemoryBarrier uploaded =
+  {
+    vk::AccessFlagBits::eTransferWrite,
+    vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eIndirectCommandRead |
+    vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead
+  };
+
+  frame.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                      vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader |
+                                      vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                                      {}, 1, &uploaded, 0, nullptr, 0, nullptr);
+
+  frame.commandBuffer.end();
+
+  vk::SubmitInfo submitInfo = { 0, nullptr, nullptr, 1, &frame.commandBuffer };
+
+  auto result = queue->submit(1, &submitInfo, frame.fence);
+  helper::ThrowIfNotSuccess(result, "Failed to submit uploads");
+
+  frame.end = head;
+  frame.pending = true;
+
+  current = (current + 1) % FrameCount;
+  recording = false;
+}
+
+void lpe::StagingRing::Flush()
+{
+  Submit();
+
+  while (RetireOldest(true))
+  {
+  }
+}
+
+vk::DeviceSize lpe::StagingRing::GetSize() const
+{
+  return size;
+}
@@ -0,0 +1,136 @@
+#include "../include/StaticBaker.h"
+#include "../include/Palette.h"
+#include <cmath>
+
+namespace
+{
+  // the colors of mesh which aren't part of colors yet
+  size_t CountNewColors(const std::unordered_set<glm::vec3>& colors, const std::vector<glm::vec3>& mesh)
+  {
+    size_t count = 0;
+
+    for (const auto& color : mesh)
+    {
+      if (colors.find(color) == colors.end())
+      {
+        count++;
+      }
+    }
+
+    return count;
+  }
+}
+
+lpe::StaticBaker::StaticBaker(float chunkSize)
+  : chunkSize(chunkSize)
+{
+}
+
+const std::vector<lpe::Vertex>& lpe::StaticBaker::Unpack(const Mesh& mesh)
+{
+  auto entry = unpacked.find(&mesh);
+
+  if (entry == unpacked.end())
+  {
+    entry = unpacked.insert(std::make_pair(&mesh, mesh.Unpack())).first;
+  }
+
+  return entry->second;
+}
+
+void lpe::StaticBaker::Add(const Mesh& mesh, const InstanceData& instance)
+{
+  if (mesh.lods.empty())
+  {
+    return;
+  }
+
+  const auto& vertices = Unpack(mesh);
+  const auto& lod = mesh.lods[0];
+
+  const glm::mat4 matrix(instance.row1, instance.row2, instance.row3, instance.row4);
+  const glm::mat3 rotation(matrix);
+  const glm::mat3 normalMatrix = glm::transpose(glm::inverse(rotation));
+
+  const glm::vec3 center = glm::vec3(matrix * glm::vec4(mesh.center, 1.0f));
+  const ChunkKey key((int32_t)std::floor(center.x / chunkSize), (int32_t)std::floor(center.y / chunkSize), (int32_t)std::floor(center.z / chunkSize), (uint32_t)mesh.format);
+
+  auto& cell = chunks[key];
+
+  const bool palette = mesh.format == VertexFormat::Palette;
+
+  if (cell.empty() || cell.back().mesh->vertices.size() + vertices.size() > MaxVertices ||
+      (palette && cell.back().colors.size() + CountNewColors(cell.back().colors, mesh.palette) > Palette::MaxColors))
+  {
+    cell.push_back({ std::make_shared<Mesh>(), {} });
+    cell.back().mesh->path = "static chunk";
+  }
+
+  if (palette)
+  {
+    cell.back().colors.insert(std::begin(mesh.palette), std::end(mesh.palette));
+  }
+
+  auto& chunk = *cell.back().mesh;
+  const uint32_t baseVertex = (uint32_t)chunk.vertices.size();
+
+  chunk.vertices.reserve(chunk.vertices.size() + vertices.size());
+
+  for (const auto& vertex : vertices)
+  {
+    Vertex world = vertex;
+    world.position = glm::vec3(matrix * glm::vec4(vertex.position, 1.0f));
+
+    // flat shaded formats have no normals
+    if (glm::length(vertex.normals) > 0.0f)
+    {
+      world.normals = glm::normalize(normalMatrix * vertex.normals);
+    }
+
+    chunk.vertices.push_back(world);
+  }
+
+  // mirroring instances turn the triangles inside out, swapping two corners restores the winding
+  const bool mirrored = glm::determinant(rotation) < 0.0f;
+
+  chunk.indices.reserve(chunk.indices.size() + lod.indexCount);
+
+  for (uint32_t i = lod.indexOffset; i + 2 < lod.indexOffset + lod.indexCount; i += 3)
+  {
+    chunk.indices.push_back(baseVertex + mesh.indices[i]);
+    chunk.indices.push_back(baseVertex + mesh.indices[mirrored ? i + 2 : i + 1]);
+    chunk.indices.push_back(baseVertex + mesh.indices[mirrored ? i + 1 : i + 2]);
+  }
+}
+
+std::vector<std::shared_ptr<const lpe::Mesh>> lpe::StaticBaker::Build()
+{
+  std::vector<std::shared_ptr<const Mesh>> built;
+
+  for (auto& cell : chunks)
+  {
+    const auto format = (VertexFormat)std::get<3>(cell.first);
+
+    for (auto& entry : cell.second)
+    {
+      auto& chunk = entry.mesh;
+
+      chunk->stats = {};
+      chunk->stats.sourceVertexCount = (uint32_t)chunk->vertices.size();
+      chunk->stats.sourceIndexCount = (uint32_t)chunk->indices.size();
+
+      chunk->lods = { { 0, (uint32_t)chunk->indices.size(), 0.0f } };
+      chunk->ComputeBounds();
+
+      // quantized relative to the chunk's bounds, which are larger than the ones of a single mesh
+      chunk->Pack(format);
+
+      built.push_back(chunk);
+    }
+  }
+
+  chunks.clear();
+  unpacked.clear();
+
+  return built;
+}
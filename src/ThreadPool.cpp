@@ -0,0 +1,83 @@
+#include "../include/ThreadPool.h"
+#include <algorithm>
+
+lpe::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+  threadCount = std::max(threadCount, 1u);
+
+  for (uint32_t i = 0; i < threadCount; ++i)
+  {
+    workers.emplace_back(&ThreadPool::Work, this);
+  }
+}
+
+lpe::ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  condition.notify_all();
+
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+}
+
+void lpe::ThreadPool::Work()
+{
+  for (;;)
+  {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+      if (stopping && tasks.empty())
+      {
+        return;
+      }
+
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+
+    task();
+  }
+}
+
+bool lpe::ThreadPool::RunPendingTask()
+{
+  std::function<void()> task;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (tasks.empty())
+    {
+      return false;
+    }
+
+    task = std::move(tasks.front());
+    tasks.pop();
+  }
+
+  task();
+
+  return true;
+}
+
+uint32_t lpe::ThreadPool::GetThreadCount() const
+{
+  return (uint32_t)workers.size();
+}
+
+lpe::ThreadPool& lpe::ThreadPool::Shared()
+{
+  static ThreadPool pool(std::thread::hardware_concurrency());
+
+  return pool;
+}
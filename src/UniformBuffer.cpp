@@ -1,7 +1,57 @@
 #include "../include/UniformBuffer.h"
 #include "../include/ModelsRenderer.h"
+#include "../include/Palette.h"
 #include <glm/gtc/matrix_transform.hpp>
 
+namespace
+{
+  // clean runs up to this many instances are copied along, fewer regions are cheaper than a few extra bytes
+  const size_t MaxCleanGap = 4;
+
+  // appends the instances between begin and end which differ from uploaded, uploaded only mirrors the buffer below valid
+  void FindDirtyRanges(const uint8_t* current, const std::vector<uint8_t>& uploaded, size_t valid, size_t begin, size_t end, size_t stride, std::vector<vk::BufferCopy>& ranges)
+  {
+    size_t clean = MaxCleanGap + 1;
+
+    for (size_t offset = begin; offset < end; offset += stride)
+    {
+      if (offset + stride <= valid && memcmp(current + offset, uploaded.data() + offset, stride) == 0)
+      {
+        clean++;
+        continue;
+      }
+
+      if (!ranges.empty() && clean <= MaxCleanGap)
+      {
+        ranges.back().size = offset + stride - ranges.back().srcOffset;
+      }
+      else
+      {
+        ranges.push_back({ offset, offset, stride });
+      }
+
+      clean = 0;
+    }
+  }
+
+  // recreates the buffer if it is smaller than size, twice as large as before so a growing instance count rarely does that
+  // returns true if the buffer was recreated, command buffers which bind it have to be recorded again
+  bool Reserve(lpe::Buffer& buffer, vk::PhysicalDevice physicalDevice, vk::Device* device, vk::DeviceSize size, vk::BufferUsageFlags usage)
+  {
+    if (buffer.GetBuffer() && buffer.GetSize() >= size)
+    {
+      return false;
+    }
+
+    const vk::DeviceSize capacity = buffer.GetBuffer() ? std::max(size, buffer.GetSize() * 2) : size;
+
+    buffer.Destroy();
+    buffer = { physicalDevice, device, capacity, usage, vk::MemoryPropertyFlagBits::eDeviceLocal };
+
+    return true;
+  }
+}
+
 lpe::UniformBuffer::UniformBuffer(const UniformBuffer& other)
 {
   this->device.reset(other.device.get());
@@ -9,6 +59,15 @@ lpe::UniformBuffer::UniformBuffer(const UniformBuffer& other)
   this->ubo = other.ubo;
   this->viewBuffer = other.viewBuffer;
   this->instanceBuffer = other.instanceBuffer;
+  this->instanceBuilder = other.instanceBuilder;
+  this->instanceParameters = other.instanceParameters;
+  this->uploadedInstances = other.uploadedInstances;
+  this->animationBuffer = other.animationBuffer;
+  this->uploadedAnimations = other.uploadedAnimations;
+  this->paletteBuffer = other.paletteBuffer;
+  this->paletteVersion = other.paletteVersion;
+  this->instanceEncoding = other.instanceEncoding;
+  this->encodedInstances = other.encodedInstances;
 }
 
 lpe::UniformBuffer::UniformBuffer(UniformBuffer&& other)
@@ -20,6 +79,15 @@ lpe::UniformBuffer::UniformBuffer(UniformBuffer&& other)
   this->ubo = other.ubo;
   this->viewBuffer = std::move(other.viewBuffer);
   this->instanceBuffer = std::move(other.instanceBuffer);
+  this->instanceBuilder = other.instanceBuilder;
+  this->instanceParameters = std::move(other.instanceParameters);
+  this->uploadedInstances = std::move(other.uploadedInstances);
+  this->animationBuffer = std::move(other.animationBuffer);
+  this->uploadedAnimations = std::move(other.uploadedAnimations);
+  this->paletteBuffer = std::move(other.paletteBuffer);
+  this->paletteVersion = other.paletteVersion;
+  this->instanceEncoding = other.instanceEncoding;
+  this->encodedInstances = std::move(other.encodedInstances);
 }
 
 lpe::UniformBuffer& lpe::UniformBuffer::operator=(const UniformBuffer& other)
@@ -29,6 +97,15 @@ lpe::UniformBuffer& lpe::UniformBuffer::operator=(const UniformBuffer& other)
   this->ubo = other.ubo;
   this->viewBuffer = other.viewBuffer;
   this->instanceBuffer = other.instanceBuffer;
+  this->instanceBuilder = other.instanceBuilder;
+  this->instanceParameters = other.instanceParameters;
+  this->uploadedInstances = other.uploadedInstances;
+  this->animationBuffer = other.animationBuffer;
+  this->uploadedAnimations = other.uploadedAnimations;
+  this->paletteBuffer = other.paletteBuffer;
+  this->paletteVersion = other.paletteVersion;
+  this->instanceEncoding = other.instanceEncoding;
+  this->encodedInstances = other.encodedInstances;
 
   return *this;
 }
@@ -42,6 +119,15 @@ lpe::UniformBuffer& lpe::UniformBuffer::operator=(UniformBuffer&& other)
   this->ubo = other.ubo;
   this->viewBuffer = std::move(other.viewBuffer);
   this->instanceBuffer = std::move(other.instanceBuffer);
+  this->instanceBuilder = other.instanceBuilder;
+  this->instanceParameters = std::move(other.instanceParameters);
+  this->uploadedInstances = std::move(other.uploadedInstances);
+  this->animationBuffer = std::move(other.animationBuffer);
+  this->uploadedAnimations = std::move(other.uploadedAnimations);
+  this->paletteBuffer = std::move(other.paletteBuffer);
+  this->paletteVersion = other.paletteVersion;
+  this->instanceEncoding = other.instanceEncoding;
+  this->encodedInstances = std::move(other.encodedInstances);
 
   return *this;
 }
@@ -50,13 +136,20 @@ lpe::UniformBuffer::UniformBuffer(vk::PhysicalDevice physicalDevice,
                                   vk::Device* device,
                                   ModelsRenderer& modelsRenderer,
                                   const Camera& camera, 
-                                  const Commands& commands)
-  : physicalDevice(physicalDevice)
+                                  const Commands& commands,
+                                  InstanceEncoding instanceEncoding,
+                                  InstanceBuilder* instanceBuilder)
+  : physicalDevice(physicalDevice),
+    instanceEncoding(instanceEncoding),
+    instanceBuilder(instanceBuilder)
 {
   this->device.reset(device);
 
   viewBuffer = {physicalDevice, device, sizeof(ubo)};
   instanceBuffer = { physicalDevice, device };
+  instanceParameters = { physicalDevice, device };
+  animationBuffer = { physicalDevice, device };
+  paletteBuffer = { physicalDevice, device, Palette::MaxColors * sizeof(glm::vec4) };
 	
   
   Update(camera, modelsRenderer, commands);
@@ -70,7 +163,7 @@ lpe::UniformBuffer::~UniformBuffer()
   }
 }
 
-void lpe::UniformBuffer::Update(const Camera& camera, ModelsRenderer& renderer, const Commands& commands)
+bool lpe::UniformBuffer::Update(const Camera& camera, ModelsRenderer& renderer, const Commands& commands)
 {
   ubo.view = camera.GetView();
   ubo.projection = camera.GetPerspective();
@@ -78,29 +171,138 @@ void lpe::UniformBuffer::Update(const Camera& camera, ModelsRenderer& renderer,
 
   viewBuffer.CopyToBufferMemory(&ubo, sizeof(ubo));
 
-  std::vector<InstanceData> instanceData = renderer.GetInstanceData();
+  // the gpu is idle between frames (presentQueue.waitIdle in Device::SubmitFrame), so the colors can be overwritten in place
+  if (Palette::Shared().GetVersion() != paletteVersion)
+  {
+    auto colors = Palette::Shared().GetColors(paletteVersion);
+    paletteBuffer.CopyToBufferMemory(colors.data(), colors.size() * sizeof(glm::vec4));
+  }
+
+  renderer.UpdateInstanceData(camera, changedInstances);
+
+  const auto& instanceData = renderer.GetInstanceData();
+  const auto& animationData = renderer.GetAnimationData();
 
   if (instanceData.empty())
-    return;
+    return false;
+
+  const uint32_t instanceCount = (uint32_t)instanceData.size();
+  const uint32_t stride = GetInstanceStride(instanceEncoding);
+
+  // the other instances are still encoded from an earlier frame, unless this is the first one
+  if (encodedInstances.empty())
+  {
+    changedInstances = { { 0, instanceCount } };
+  }
+
+  encodedInstances.resize(instanceCount * stride);
+
+  for (auto range : changedInstances)
+  {
+    EncodeInstances(instanceData.data() + range.first, range.count, instanceEncoding, encodedInstances.data() + range.first * stride);
+  }
 
-	if (instanceData.size() * sizeof(InstanceData) != instanceBuffer.GetSize())
-	{
-		vk::DeviceSize size = instanceData.size() * sizeof(InstanceData);
+  bool recreated = false;
+  bool instancesRecreated = false;
 
-		// totally dump and inefficient
-    instanceBuffer.CreateStaged(commands, size, instanceData.data(), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-	}
+  if (instanceBuilder)
+  {
+    const bool parametersRecreated = Reserve(instanceParameters, physicalDevice, device.get(), encodedInstances.size(), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer);
+    recreated = Reserve(instanceBuffer, physicalDevice, device.get(), instanceCount * sizeof(InstanceData), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer);
+
+    if (parametersRecreated || recreated)
+    {
+      instanceBuilder->UpdateDescriptorSets(instanceParameters.GetDescriptor(), instanceBuffer.GetDescriptor());
+    }
+
+    // uploading all parameters builds all matrices again
+    instancesRecreated = parametersRecreated || recreated;
+  }
   else
   {
-    auto cmdBuffer = commands.BeginSingleTimeCommands();
-    instanceBuffer.CopyStaged(cmdBuffer, instanceData.data());
-    commands.EndSingleTimeCommands(cmdBuffer);
+    recreated = Reserve(instanceBuffer, physicalDevice, device.get(), encodedInstances.size(), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer);
+    instancesRecreated = recreated;
+  }
+
+  FindChanges(encodedInstances.data(), encodedInstances.size(), stride, instancesRecreated, uploadedInstances, dirtyRanges);
+
+  const vk::DeviceSize animationSize = animationData.size() * sizeof(AnimationData);
+  const bool animationsRecreated = Reserve(animationBuffer, physicalDevice, device.get(), animationSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer);
+
+  FindChanges(animationData.data(), animationSize, sizeof(AnimationData), animationsRecreated, uploadedAnimations, animationRanges);
+
+  if (animationsRecreated)
+  {
+    recreated = true;
+  }
+
+  // nothing moved, nothing to copy or build, animated instances only change ubo.time
+  if (dirtyRanges.empty() && animationRanges.empty())
+  {
+    return recreated;
+  }
+
+  // only the changed ranges are staged, the ring's command buffer is submitted without waiting
+  auto& stagingRing = commands.GetStagingRing();
+
+  if (!dirtyRanges.empty())
+  {
+    // the buffer the encoded instances are copied into
+    Buffer& uploadTarget = instanceBuilder ? instanceParameters : instanceBuffer;
+    stagingRing.Upload(uploadTarget, encodedInstances.data(), dirtyRanges);
+
+    if (instanceBuilder)
+    {
+      builtRanges.clear();
+
+      for (const auto& range : dirtyRanges)
+      {
+        builtRanges.push_back({ (uint32_t)(range.dstOffset / stride), (uint32_t)(range.size / stride) });
+      }
+
+      instanceBuilder->Build(stagingRing.GetCommandBuffer(), builtRanges);
+    }
+  }
+
+  if (!animationRanges.empty())
+  {
+    stagingRing.Upload(animationBuffer, animationData.data(), animationRanges);
+  }
+
+  stagingRing.Submit();
+
+  return recreated;
+}
+
+void lpe::UniformBuffer::FindChanges(const void* data, vk::DeviceSize size, vk::DeviceSize stride, bool recreated, std::vector<uint8_t>& uploaded, std::vector<vk::BufferCopy>& ranges)
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  ranges.clear();
+
+  if (recreated)
+  {
+    ranges.push_back({ 0, 0, size });
+    uploaded.assign(bytes, bytes + size);
+    return;
+  }
+
+  // the buffer kept its contents, only the instances the renderer wrote again can differ
+  const size_t valid = uploaded.size();
+  uploaded.resize((size_t)size);
+
+  for (auto range : changedInstances)
+  {
+    const size_t begin = (size_t)(range.first * stride);
+    const size_t end = (size_t)((range.first + range.count) * stride);
+
+    FindDirtyRanges(bytes, uploaded, valid, begin, end, (size_t)stride, ranges);
+    memcpy(uploaded.data() + begin, bytes + begin, end - begin);
   }
 }
 
 std::vector<vk::DescriptorBufferInfo> lpe::UniformBuffer::GetDescriptors()
 {
-  return { viewBuffer.GetDescriptor(), instanceBuffer.GetDescriptor() };
+  return { viewBuffer.GetDescriptor(), instanceBuffer.GetDescriptor(), paletteBuffer.GetDescriptor() };
 }
 
 void lpe::UniformBuffer::SetLightPosition(glm::vec3 light)
@@ -108,7 +310,22 @@ void lpe::UniformBuffer::SetLightPosition(glm::vec3 light)
   ubo.lightPos = light;
 }
 
+void lpe::UniformBuffer::SetTime(float time)
+{
+  ubo.time = time;
+}
+
+lpe::InstanceEncoding lpe::UniformBuffer::GetInstanceEncoding() const
+{
+  return instanceBuilder ? InstanceEncoding::Matrix : instanceEncoding;
+}
+
 vk::Buffer lpe::UniformBuffer::GetInstanceBuffer()
 {
 	return instanceBuffer.GetBuffer();
+}
+
+vk::Buffer lpe::UniformBuffer::GetAnimationBuffer()
+{
+  return animationBuffer.GetBuffer();
 }
\ No newline at end of file
@@ -1,5 +1,65 @@
 #include "../include/Vertex.h"
-#include "../include/Instance.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  void AddInstanceAttributes(std::vector<vk::VertexInputAttributeDescription>& descriptions, lpe::InstanceEncoding encoding)
+  {
+    auto instanceDescriptions = lpe::GetInstanceAttributeDescriptions(encoding);
+    descriptions.insert(std::end(descriptions), std::begin(instanceDescriptions), std::end(instanceDescriptions));
+
+    auto animationDescriptions = lpe::GetAnimationAttributeDescriptions();
+    descriptions.insert(std::end(descriptions), std::begin(animationDescriptions), std::end(animationDescriptions));
+  }
+
+  int16_t ToSnorm16(float value)
+  {
+    return (int16_t)std::round(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+  }
+
+  uint8_t ToUnorm8(float value)
+  {
+    return (uint8_t)std::round(std::max(0.0f, std::min(1.0f, value)) * 255.0f);
+  }
+
+  float SignNotZero(float value)
+  {
+    return value >= 0.0f ? 1.0f : -1.0f;
+  }
+
+  void PackPosition(int16_t* packed, glm::vec3 position, glm::vec3 center, float radius)
+  {
+    const glm::vec3 relative = radius > 0.0f ? (position - center) / radius : glm::vec3(0.0f);
+    packed[0] = ToSnorm16(relative.x);
+    packed[1] = ToSnorm16(relative.y);
+    packed[2] = ToSnorm16(relative.z);
+    packed[3] = ToSnorm16(1.0f);
+  }
+
+  void PackColor(uint8_t* packed, glm::vec3 color)
+  {
+    packed[0] = ToUnorm8(color.x);
+    packed[1] = ToUnorm8(color.y);
+    packed[2] = ToUnorm8(color.z);
+    packed[3] = 255;
+  }
+
+  float FromSnorm16(int16_t value)
+  {
+    return std::max(-1.0f, value / 32767.0f);
+  }
+
+  glm::vec3 UnpackPosition(const int16_t* packed, glm::vec3 center, float radius)
+  {
+    return center + glm::vec3(FromSnorm16(packed[0]), FromSnorm16(packed[1]), FromSnorm16(packed[2])) * radius;
+  }
+
+  glm::vec3 UnpackColor(const uint8_t* packed)
+  {
+    return glm::vec3(packed[0] / 255.0f, packed[1] / 255.0f, packed[2] / 255.0f);
+  }
+}
 
 lpe::Vertex::Vertex(std::initializer_list<glm::vec3> list)
 {
@@ -17,20 +77,21 @@ lpe::Vertex::Vertex(std::initializer_list<glm::vec3> list)
   }
 }
 
-std::vector<vk::VertexInputBindingDescription> lpe::Vertex::GetBindingDescription()
+std::vector<vk::VertexInputBindingDescription> lpe::Vertex::GetBindingDescription(InstanceEncoding encoding)
 {
   std::vector<vk::VertexInputBindingDescription> bindings =
   {
     {0, sizeof(Vertex), vk::VertexInputRate::eVertex},
-    {1, sizeof(InstanceData), vk::VertexInputRate::eInstance}
+    GetInstanceBindingDescription(encoding),
+    GetAnimationBindingDescription()
   };
 
   return bindings;
 }
 
-std::vector<vk::VertexInputAttributeDescription> lpe::Vertex::GetAttributeDescriptions()
+std::vector<vk::VertexInputAttributeDescription> lpe::Vertex::GetAttributeDescriptions(InstanceEncoding encoding)
 {
-  std::vector<vk::VertexInputAttributeDescription> descriptions(7);
+  std::vector<vk::VertexInputAttributeDescription> descriptions(3);
 
   // Per-Vertex attributes
   descriptions[0] = {0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, position)};
@@ -38,10 +99,7 @@ std::vector<vk::VertexInputAttributeDescription> lpe::Vertex::GetAttributeDescri
   descriptions[2] = {2, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color)};
   
   // Per-Instance attributes
-  descriptions[3] = { 3, 1, vk::Format::eR32G32B32A32Sfloat, offsetof(InstanceData, row1) };
-  descriptions[4] = { 4, 1, vk::Format::eR32G32B32A32Sfloat, offsetof(InstanceData, row2) };
-  descriptions[5] = { 5, 1, vk::Format::eR32G32B32A32Sfloat, offsetof(InstanceData, row3) };
-  descriptions[6] = { 6, 1, vk::Format::eR32G32B32A32Sfloat, offsetof(InstanceData, row4) };
+  AddInstanceAttributes(descriptions, encoding);
 
   return descriptions;
 }
@@ -52,3 +110,196 @@ bool lpe::Vertex::operator==(const Vertex& other) const
          normals == other.normals &&
          color == other.color;
 }
+
+lpe::PackedVertex lpe::PackedVertex::Pack(const Vertex& vertex, glm::vec3 center, float radius)
+{
+  PackedVertex packed;
+
+  PackPosition(packed.position, vertex.position, center, radius);
+
+  // projects the normal onto an octahedron and unfolds its lower half over the upper one
+  glm::vec3 normal = vertex.normals;
+  const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  float x = length > 0.0f ? normal.x / length : 0.0f;
+  float y = length > 0.0f ? normal.y / length : 0.0f;
+
+  if (length > 0.0f && normal.z < 0.0f)
+  {
+    const float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+    const float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+    x = foldedX;
+    y = foldedY;
+  }
+
+  packed.normal[0] = ToSnorm16(x);
+  packed.normal[1] = ToSnorm16(y);
+
+  PackColor(packed.color, vertex.color);
+
+  return packed;
+}
+
+lpe::Vertex lpe::PackedVertex::Unpack(glm::vec3 center, float radius) const
+{
+  Vertex vertex;
+
+  vertex.position = UnpackPosition(position, center, radius);
+  vertex.color = UnpackColor(color);
+
+  // folds the lower half of the octahedron back, like shaders/packed.vert
+  float x = FromSnorm16(normal[0]);
+  float y = FromSnorm16(normal[1]);
+  const float z = 1.0f - std::abs(x) - std::abs(y);
+
+  if (z < 0.0f)
+  {
+    const float unfoldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+    const float unfoldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+    x = unfoldedX;
+    y = unfoldedY;
+  }
+
+  vertex.normals = glm::normalize(glm::vec3(x, y, z));
+
+  return vertex;
+}
+
+std::vector<vk::VertexInputBindingDescription> lpe::PackedVertex::GetBindingDescription(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputBindingDescription> bindings =
+  {
+    {0, sizeof(PackedVertex), vk::VertexInputRate::eVertex},
+    GetInstanceBindingDescription(encoding),
+    GetAnimationBindingDescription()
+  };
+
+  return bindings;
+}
+
+std::vector<vk::VertexInputAttributeDescription> lpe::PackedVertex::GetAttributeDescriptions(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputAttributeDescription> descriptions(3);
+
+  // Per-Vertex attributes, decoded by shaders/packed.vert
+  descriptions[0] = {0, 0, vk::Format::eR16G16B16A16Snorm, offsetof(PackedVertex, position)};
+  descriptions[1] = {1, 0, vk::Format::eR16G16Snorm, offsetof(PackedVertex, normal)};
+  descriptions[2] = {2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(PackedVertex, color)};
+
+  // Per-Instance attributes
+  AddInstanceAttributes(descriptions, encoding);
+
+  return descriptions;
+}
+
+lpe::FlatVertex lpe::FlatVertex::Pack(const Vertex& vertex, glm::vec3 center, float radius)
+{
+  FlatVertex packed;
+
+  PackPosition(packed.position, vertex.position, center, radius);
+  PackColor(packed.color, vertex.color);
+
+  return packed;
+}
+
+lpe::Vertex lpe::FlatVertex::Unpack(glm::vec3 center, float radius) const
+{
+  Vertex vertex;
+
+  vertex.position = UnpackPosition(position, center, radius);
+  vertex.color = UnpackColor(color);
+  vertex.normals = glm::vec3(0.0f);
+
+  return vertex;
+}
+
+std::vector<vk::VertexInputBindingDescription> lpe::FlatVertex::GetBindingDescription(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputBindingDescription> bindings =
+  {
+    {0, sizeof(FlatVertex), vk::VertexInputRate::eVertex},
+    GetInstanceBindingDescription(encoding),
+    GetAnimationBindingDescription()
+  };
+
+  return bindings;
+}
+
+std::vector<vk::VertexInputAttributeDescription> lpe::FlatVertex::GetAttributeDescriptions(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputAttributeDescription> descriptions(2);
+
+  // Per-Vertex attributes, decoded by shaders/flat.vert
+  descriptions[0] = {0, 0, vk::Format::eR16G16B16A16Snorm, offsetof(FlatVertex, position)};
+  descriptions[1] = {2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(FlatVertex, color)};
+
+  // Per-Instance attributes
+  AddInstanceAttributes(descriptions, encoding);
+
+  return descriptions;
+}
+
+lpe::PaletteVertex lpe::PaletteVertex::Pack(const Vertex& vertex, glm::vec3 center, float radius, uint16_t color)
+{
+  PaletteVertex packed;
+
+  int16_t position[4];
+  PackPosition(position, vertex.position, center, radius);
+
+  std::copy(position, position + 3, packed.position);
+  packed.color = color;
+
+  return packed;
+}
+
+lpe::Vertex lpe::PaletteVertex::Unpack(glm::vec3 center, float radius, const std::vector<glm::vec3>& palette) const
+{
+  Vertex vertex;
+
+  vertex.position = UnpackPosition(position, center, radius);
+  vertex.color = color < palette.size() ? palette[color] : glm::vec3(0.0f);
+  vertex.normals = glm::vec3(0.0f);
+
+  return vertex;
+}
+
+std::vector<vk::VertexInputBindingDescription> lpe::PaletteVertex::GetBindingDescription(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputBindingDescription> bindings =
+  {
+    {0, sizeof(PaletteVertex), vk::VertexInputRate::eVertex},
+    GetInstanceBindingDescription(encoding),
+    GetAnimationBindingDescription()
+  };
+
+  return bindings;
+}
+
+std::vector<vk::VertexInputAttributeDescription> lpe::PaletteVertex::GetAttributeDescriptions(InstanceEncoding encoding)
+{
+  std::vector<vk::VertexInputAttributeDescription> descriptions(1);
+
+  // Per-Vertex attributes, the position and color index are read as integers and decoded by shaders/palette.vert
+  descriptions[0] = {0, 0, vk::Format::eR16G16B16A16Sint, offsetof(PaletteVertex, position)};
+
+  // Per-Instance attributes
+  AddInstanceAttributes(descriptions, encoding);
+
+  return descriptions;
+}
+
+uint32_t lpe::GetVertexStride(VertexFormat format)
+{
+  switch (format)
+  {
+  case VertexFormat::Float:
+    return sizeof(Vertex);
+  case VertexFormat::Packed:
+    return sizeof(PackedVertex);
+  case VertexFormat::Flat:
+    return sizeof(FlatVertex);
+  case VertexFormat::Palette:
+    return sizeof(PaletteVertex);
+  default:
+    throw std::runtime_error("unknown vertex format");
+  }
+}
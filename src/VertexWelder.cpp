@@ -0,0 +1,136 @@
+#include "../include/VertexWelder.h"
+#include <cmath>
+
+namespace
+{
+  const uint32_t EmptySlot = ~0u;
+
+  int64_t Quantize(float value, float epsilon)
+  {
+    return (int64_t)std::floor(value / epsilon + 0.5f);
+  }
+
+  size_t Combine(size_t seed, int64_t value)
+  {
+    return seed ^ (std::hash<int64_t>()(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+  }
+
+  size_t Mix(size_t hash)
+  {
+    // the table is indexed by the low bits, spread the bits of weak hashes over them
+    uint64_t value = (uint64_t)hash;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+
+    return (size_t)value;
+  }
+}
+
+lpe::VertexWelder::VertexWelder(float epsilon)
+  : epsilon(epsilon)
+{
+}
+
+size_t lpe::VertexWelder::Hash(const Vertex& vertex) const
+{
+  if (epsilon <= 0.0f)
+  {
+    return Mix(std::hash<Vertex>()(vertex));
+  }
+
+  const float* values = &vertex.position.x;
+
+  size_t hash = 0;
+  for (uint32_t i = 0; i < 9; i++)
+  {
+    hash = Combine(hash, Quantize(values[i], epsilon));
+  }
+
+  return Mix(hash);
+}
+
+bool lpe::VertexWelder::Equal(const Vertex& a, const Vertex& b) const
+{
+  if (epsilon <= 0.0f)
+  {
+    return a == b;
+  }
+
+  const float* valuesA = &a.position.x;
+  const float* valuesB = &b.position.x;
+
+  for (uint32_t i = 0; i < 9; i++)
+  {
+    if (Quantize(valuesA[i], epsilon) != Quantize(valuesB[i], epsilon))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint32_t lpe::VertexWelder::Weld(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+  static_assert(sizeof(Vertex) == 9 * sizeof(float), "Vertex is hashed as 9 consecutive floats");
+
+  const uint32_t count = (uint32_t)vertices.size();
+
+  // keep the load factor below 2/3, so probe sequences stay short
+  size_t capacity = 16;
+  while (capacity < count + count / 2)
+  {
+    capacity <<= 1;
+  }
+
+  const size_t mask = capacity - 1;
+
+  table.assign(capacity, EmptySlot);
+  remap.resize(count);
+
+  // unique vertices are compacted to the front of the array while iterating
+  // the table refers to the compacted positions, which are never overwritten again
+  uint32_t unique = 0;
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    size_t slot = Hash(vertices[i]) & mask;
+
+    while (true)
+    {
+      const uint32_t candidate = table[slot];
+
+      if (candidate == EmptySlot)
+      {
+        table[slot] = unique;
+        vertices[unique] = vertices[i];
+        remap[i] = unique++;
+        break;
+      }
+
+      if (Equal(vertices[candidate], vertices[i]))
+      {
+        remap[i] = candidate;
+        break;
+      }
+
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  for (auto& index : indices)
+  {
+    if (index >= count)
+    {
+      throw std::runtime_error("vertex index out of range");
+    }
+
+    index = remap[index];
+  }
+
+  vertices.resize(unique);
+  vertices.shrink_to_fit();
+
+  return unique;
+}
@@ -26,7 +26,12 @@ void lpe::Window::Create()
   swapChain = device.CreateSwapChain(width, height);
   defaultCamera = { {3,0,0}, {0,0,0}, swapChain.GetExtent(), 110, 0.1f, 256 };
 
-  uniformBuffer = device.CreateUniformBuffer(modelsRenderer, defaultCamera, commands);
+  if (buildInstancesOnGpu)
+  {
+    instanceBuilder = device.CreateInstanceBuilder(instanceEncoding);
+  }
+
+  uniformBuffer = device.CreateUniformBuffer(modelsRenderer, defaultCamera, commands, instanceEncoding, buildInstancesOnGpu ? &instanceBuilder : nullptr);
   uniformBuffer.SetLightPosition({ 2, 2, 2 });
   renderPass = device.CreateRenderPass(swapChain.GetImageFormat());
   graphicsPipeline = device.CreatePipeline(swapChain, renderPass, &uniformBuffer);
@@ -164,11 +169,13 @@ void lpe::Window::MouseMoveCallback(GLFWwindow* window, double xpos, double ypos
 }
 
 
-lpe::Window::Window(uint32_t width, uint32_t height, std::string title, bool resizeable)
+lpe::Window::Window(uint32_t width, uint32_t height, std::string title, bool resizeable, InstanceEncoding instanceEncoding, bool buildInstancesOnGpu)
 	: width(width),
 	  height(height),
 	  title(title),
-	  resizeable(resizeable)
+	  resizeable(resizeable),
+	  instanceEncoding(instanceEncoding),
+	  buildInstancesOnGpu(buildInstancesOnGpu)
 {
 	Create();
 }
@@ -181,7 +188,7 @@ lpe::Window::~Window()
 	}
 }
 
-void lpe::Window::Create(uint32_t width, uint32_t height, std::string title, bool resizeable)
+void lpe::Window::Create(uint32_t width, uint32_t height, std::string title, bool resizeable, InstanceEncoding instanceEncoding, bool buildInstancesOnGpu)
 {
   if(window)
     throw std::runtime_error("Window was already created. Consider using the default constructor if you want to use this function!");
@@ -190,6 +197,8 @@ void lpe::Window::Create(uint32_t width, uint32_t height, std::string title, boo
   this->height = height;
   this->title = title;
   this->resizeable = resizeable;
+  this->instanceEncoding = instanceEncoding;
+  this->buildInstancesOnGpu = buildInstancesOnGpu;
   Create();
 }
 
@@ -205,10 +214,8 @@ void lpe::Window::AddRenderObject(RenderObject* obj)
   if (!window)
     throw std::runtime_error("Cannot add model if the window wasn't created successfully. Call Create(...) before AddRenderObject(...)!");
 
-  modelsRenderer.AddObject(obj);
-  uniformBuffer.Update(defaultCamera, modelsRenderer, commands);
-  commands.ResetCommandBuffers();
-  commands.CreateCommandBuffers(swapChain.GetFramebuffers(), swapChain.GetExtent(), renderPass, graphicsPipeline, modelsRenderer, uniformBuffer);
+  // the object shows up in a later frame, once its mesh is loaded and resident (see Render)
+  modelsRenderer.QueueObject(obj);
 }
 
 bool lpe::Window::IsOpen() const
@@ -226,7 +233,17 @@ void lpe::Window::Render()
 
 	glfwPollEvents();
 
-  uniformBuffer.Update(defaultCamera, modelsRenderer, commands);
+  // never waits, streamed objects are added once their upload is finished
+  const bool objectsAdded = modelsRenderer.ProcessQueue();
+
+  uniformBuffer.SetTime((float)glfwGetTime());
+  const bool buffersRecreated = uniformBuffer.Update(defaultCamera, modelsRenderer, commands);
+
+  if (objectsAdded || buffersRecreated)
+  {
+    commands.ResetCommandBuffers();
+    commands.CreateCommandBuffers(swapChain.GetFramebuffers(), swapChain.GetExtent(), renderPass, graphicsPipeline, modelsRenderer, uniformBuffer);
+  }
 
   uint32_t imageIndex = -1;
   vk::SubmitInfo submitInfo = device.PrepareFrame(swapChain, &imageIndex);
@@ -0,0 +1,113 @@
+// compares composing translate(position) * transform one instance at a time with glm, as the instances did before
+// InstanceStorage, with the ComposeInstances kernel and with InstanceStorage::Pack, which also encodes the animations
+// usage: ComposeBenchmark [instances] [runs]
+// the inputs come from a fixed seed, build with CMAKE_BUILD_TYPE=Release for numbers worth comparing
+
+#include "InstanceCompose.h"
+#include "InstanceStorage.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+
+namespace
+{
+  // the composition before ComposeInstances, a full matrix product per instance
+  void ComposeLegacy(const std::vector<glm::vec3>& positions, const std::vector<glm::mat4>& transforms, std::vector<lpe::InstanceData>& instances)
+  {
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+      const glm::mat4 matrix = glm::translate(glm::mat4(1.0f), positions[i]) * transforms[i];
+
+      instances[i].row1 = matrix[0];
+      instances[i].row2 = matrix[1];
+      instances[i].row3 = matrix[2];
+      instances[i].row4 = matrix[3];
+    }
+  }
+
+  // best of all runs, the first one also faults the output in
+  double Measure(uint32_t runs, const std::function<void()>& compose)
+  {
+    double best = 1e30;
+
+    for (uint32_t run = 0; run < runs; ++run)
+    {
+      auto start = std::chrono::steady_clock::now();
+      compose();
+      best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+  }
+
+  bool Same(const std::vector<lpe::InstanceData>& a, const std::vector<lpe::InstanceData>& b)
+  {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(lpe::InstanceData)) == 0;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const uint32_t count = argc > 1 ? (uint32_t)std::stoi(argv[1]) : 100000;
+  const uint32_t runs = argc > 2 ? (uint32_t)std::stoi(argv[2]) : 200;
+
+  try
+  {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> offset(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::mat4> transforms(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      positions[i] = glm::vec3(offset(random), offset(random), offset(random));
+      transforms[i] = glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(scale(random))), angle(random), glm::vec3(0.0f, 1.0f, 0.0f));
+      transforms[i][3] = glm::vec4(offset(random), offset(random), offset(random), 1.0f);
+    }
+
+    lpe::InstanceStorage storage;
+    std::vector<lpe::InstanceHandle> handles;
+    storage.Add(count, handles);
+    storage.SetPositions(0, positions.data(), count);
+    storage.SetTransforms(0, transforms.data(), count);
+
+    std::vector<lpe::InstanceData> legacyInstances(count), instances(count), packedInstances;
+    std::vector<lpe::AnimationData> animations;
+
+    const double legacy = Measure(runs, [&]() { ComposeLegacy(positions, transforms, legacyInstances); });
+    const double kernel = Measure(runs, [&]() { lpe::ComposeInstances(positions.data(), transforms.data(), nullptr, count, instances.data()); });
+    const double pack = Measure(runs, [&]()
+    {
+      packedInstances.clear();
+      animations.clear();
+      storage.Pack(packedInstances, animations);
+    });
+
+    const bool identical = Same(legacyInstances, instances) && Same(instances, packedInstances);
+
+    printf("%u instances, best of %u runs\n", count, runs);
+    printf("  glm per instance %8.1f M/s\n", count / legacy / 1e6);
+    printf("  ComposeInstances %8.1f M/s\n", count / kernel / 1e6);
+    printf("  Pack             %8.1f M/s\n", count / pack / 1e6);
+    printf("  output %s\n", identical ? "identical" : "DIFFERENT");
+
+    if (!identical)
+    {
+      return 1;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -9,37 +9,88 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <chrono>
 #include "RenderObject.h"
+#include "SceneGraph.h"
 
 int main()
 {
   lpe::settings.EnableValidationLayer = true;
 
-  lpe::RenderObject object = { "models/tree.ply", 0 };
-  lpe::RenderObject monkey = { "models/monkey.ply", 0 };
+  lpe::MeshOptions palette;
+  palette.vertexFormat = lpe::VertexFormat::Palette;
+
+  lpe::MeshOptions packed;
+  packed.vertexFormat = lpe::VertexFormat::Packed;
+
+  lpe::RenderObject object = { "models/tree.ply", 0, lpe::LoadMode::Async, palette };
+  lpe::RenderObject monkey = { "models/monkey.ply", 0, lpe::LoadMode::Async, packed };
 
   uint32_t instances = 5;
+  std::vector<lpe::InstanceHandle> trees;
+  std::vector<lpe::InstanceHandle> monkeys;
+
+  object.AddInstances(instances * instances, trees);
+  monkey.AddInstances(instances * instances, monkeys);
+
+  std::vector<glm::vec3> positions;
 
   for (uint32_t x = 0; x < instances; ++x)
   {
     for (uint32_t y = 0; y < instances; ++y)
     {
-      auto instance = object.GetInstance(x * instances + y);
-      instance->SetPosition({ x, y, 0 });
-      instance->SetTransform(glm::scale(glm::mat4(1), { 0.75f, 0.75f, 0.75f }));
-
-      instance = monkey.GetInstance(x * instances + y);
-      instance->SetPosition({ x, y, 1 });
-      instance->SetTransform(glm::scale(glm::mat4(1), { 0.5f, 0.5f, 0.5f }));
+      positions.push_back({ x, y, 0 });
     }
   }
 
+  object.GetInstances().SetPositions(0, positions.data(), (uint32_t)positions.size());
+
+  // every monkey circles above its tree
+  lpe::SceneGraph scene;
+  std::vector<lpe::SceneNode> pivots;
+
+  for (size_t i = 0; i < positions.size(); ++i)
+  {
+    pivots.push_back(scene.Add());
+
+    auto node = scene.Add(pivots.back());
+    scene.SetLocal(node, glm::translate(glm::mat4(1), { 0.25f, 0, 1 }) * glm::scale(glm::mat4(1), { 0.5f, 0.5f, 0.5f }));
+    scene.Attach(node, monkey.GetInstances(), monkeys[i]);
+  }
+
+  // the trees spin on the gpu, nothing about them is uploaded after the first frame
+  std::vector<glm::mat4> transforms(positions.size(), glm::scale(glm::mat4(1), { 0.75f, 0.75f, 0.75f }));
+  object.GetInstances().SetTransforms(trees, transforms.data());
+
+  lpe::InstanceAnimation spin;
+  spin.type = lpe::AnimationType::Spin;
+  spin.axis = { 0, 0, 1 };
+  spin.speed = glm::radians(90.0f) / 2.5f;
+
+  for (const auto& tree : trees)
+  {
+    object.GetInstances().SetAnimation(tree, spin);
+  }
+
+  // the ground never moves, its tiles are merged into a few chunks once the cube is loaded
+  lpe::RenderObject cube = { "models/cube.ply", 0, lpe::LoadMode::Async };
+  std::vector<lpe::InstanceHandle> tiles;
+  cube.AddInstances(instances * instances, tiles);
+  cube.GetInstances().SetPositions(0, positions.data(), (uint32_t)positions.size());
+
+  std::vector<glm::mat4> tileTransforms(positions.size(), glm::translate(glm::mat4(1), { 0, 0, -0.05f }) * glm::scale(glm::mat4(1), { 0.5f, 0.5f, 0.05f }));
+  cube.GetInstances().SetTransforms(tiles, tileTransforms.data());
+
+  for (const auto& tile : tiles)
+  {
+    cube.GetInstances().SetStatic(tile, true);
+  }
 
   lpe::Window window;
   try
   {
-    window.Create(1920, 1080, "LowPolyEngine", false);
+    window.Create(1920, 1080, "LowPolyEngine", false, lpe::InstanceEncoding::PositionRotationScale, true);
     window.AddRenderObject(&object);
     window.AddRenderObject(&monkey);
+    window.AddRenderObject(&cube);
 
     auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -48,17 +99,13 @@ int main()
       auto currentTime = std::chrono::high_resolution_clock::now();
       float time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 2500.0f;
 
-      for (uint32_t x = 0; x < instances; ++x)
+      for (size_t i = 0; i < pivots.size(); ++i)
       {
-        for (uint32_t y = 0; y < instances; ++y)
-        {
-          auto instance = object.GetInstance(x * instances + y);
-          instance->SetPosition({ x, y, 0 });
-          instance->SetTransform(glm::scale(glm::mat4(1), { 0.75f, 0.75f, 0.75f }));
-          instance->Transform(glm::rotate(glm::mat4(1), glm::radians(90.0f) * time, { 0, 0, 1 }));
-        }
+        scene.SetLocal(pivots[i], glm::translate(glm::mat4(1), positions[i]) * glm::rotate(glm::mat4(1), glm::radians(-180.0f) * time, { 0, 0, 1 }));
       }
 
+      scene.Update();
+
       window.Render();
     }
   }
@@ -0,0 +1,266 @@
+// compares PlyFile with the getline/istringstream loader Model::Load and RenderObject::Load used before it
+// usage: PlyBenchmark [file.ply] [scale]
+// the ascii file is repeated scale times into a temporary file, so the body is large enough to measure
+
+#include "PlyFile.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+  // the loader before PlyFile, it assumes x,y,z,nx,ny,nz,r,g,b and triangles
+  void LoadLegacy(const std::string& fileName, std::vector<lpe::Vertex>& vertices, std::vector<uint32_t>& indices)
+  {
+    std::ifstream file(fileName);
+
+    if (!file)
+    {
+      throw std::runtime_error("Failed to open model " + fileName);
+    }
+
+    std::string line;
+    bool header = true;
+    uint32_t countVertices = ~0u;
+    uint32_t countFaces = ~0u;
+
+    while (std::getline(file, line))
+    {
+      if (line.find("element vertex") != std::string::npos)
+      {
+        countVertices = std::stoi(line.substr(line.find_last_of(" ") + 1));
+      }
+      else if (line.find("element face") != std::string::npos)
+      {
+        countFaces = std::stoi(line.substr(line.find_last_of(" ") + 1));
+      }
+      else if (line == "end_header")
+      {
+        header = false;
+        break;
+      }
+    }
+
+    if (header || countVertices == ~0u || countFaces == ~0u)
+    {
+      throw std::runtime_error("file doesn't have the right format");
+    }
+
+    vertices.resize(countVertices);
+    for (uint32_t i = 0; i < countVertices; i++)
+    {
+      std::getline(file, line);
+
+      std::istringstream linepart(line);
+      std::string part;
+      uint16_t index = 0;
+      lpe::Vertex v;
+
+      while (std::getline(linepart, part, ' '))
+      {
+        if (index <= 2)
+        {
+          v.position[index] = std::stof(part);
+        }
+        else if (index <= 5)
+        {
+          v.normals[index % 3] = std::stof(part);
+        }
+        else if (index <= 8)
+        {
+          v.color[index % 3] = std::stof(part) / 255.f;
+        }
+        else
+        {
+          break;
+        }
+        index++;
+      }
+
+      vertices[i] = v;
+    }
+
+    indices.resize(countFaces * 3);
+    for (uint32_t i = 0; i < countFaces; i++)
+    {
+      std::getline(file, line);
+
+      std::istringstream linepart(line);
+      std::string part;
+      uint16_t index = 0;
+
+      while (std::getline(linepart, part, ' '))
+      {
+        if (index == 0 && std::stoi(part) != 3)
+        {
+          throw std::runtime_error("faces are not triangulated!");
+        }
+
+        if (index > 0)
+        {
+          indices[(i * 3 + index - 1)] = std::stoi(part);
+        }
+
+        index++;
+      }
+    }
+  }
+
+  // writes source scale times into one file, the faces of every copy point to its own vertices
+  std::string WriteScaled(const std::string& source, uint32_t scale)
+  {
+    std::ifstream file(source);
+
+    if (!file)
+    {
+      throw std::runtime_error("Failed to open model " + source);
+    }
+
+    std::vector<std::string> header;
+    std::string line;
+    uint32_t vertexCount = 0;
+    uint32_t faceCount = 0;
+
+    while (std::getline(file, line) && line != "end_header")
+    {
+      if (line.find("format") == 0 && line.find("ascii") == std::string::npos)
+      {
+        throw std::runtime_error("The benchmark needs an ascii ply file!");
+      }
+
+      if (line.find("element vertex") == 0)
+      {
+        vertexCount = std::stoi(line.substr(line.find_last_of(" ") + 1));
+        line = "element vertex " + std::to_string(vertexCount * scale);
+      }
+      else if (line.find("element face") == 0)
+      {
+        faceCount = std::stoi(line.substr(line.find_last_of(" ") + 1));
+        line = "element face " + std::to_string(faceCount * scale);
+      }
+
+      header.push_back(line);
+    }
+
+    std::vector<std::string> vertexLines(vertexCount);
+    for (auto& vertex : vertexLines)
+    {
+      std::getline(file, vertex);
+    }
+
+    std::vector<std::vector<uint32_t>> faces(faceCount);
+    for (auto& face : faces)
+    {
+      std::getline(file, line);
+      std::istringstream values(line);
+
+      uint32_t count, index;
+      values >> count;
+      while (values >> index)
+      {
+        face.push_back(index);
+      }
+    }
+
+    const std::string target = "PlyBenchmark.ply";
+    std::ofstream output(target);
+
+    for (const auto& headerLine : header)
+    {
+      output << headerLine << '\n';
+    }
+    output << "end_header\n";
+
+    for (uint32_t copy = 0; copy < scale; ++copy)
+    {
+      for (const auto& vertex : vertexLines)
+      {
+        output << vertex << '\n';
+      }
+    }
+
+    for (uint32_t copy = 0; copy < scale; ++copy)
+    {
+      for (const auto& face : faces)
+      {
+        output << face.size();
+        for (auto index : face)
+        {
+          output << ' ' << index + copy * vertexCount;
+        }
+        output << '\n';
+      }
+    }
+
+    return target;
+  }
+
+  // best of a few runs, the first one also warms the page cache
+  double Measure(const std::function<void()>& load)
+  {
+    double best = 1e30;
+
+    for (int run = 0; run < 3; ++run)
+    {
+      auto start = std::chrono::steady_clock::now();
+      load();
+      best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+  }
+
+  bool Same(const std::vector<lpe::Vertex>& a, const std::vector<lpe::Vertex>& b)
+  {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(lpe::Vertex)) == 0;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const std::string source = argc > 1 ? argv[1] : "models/monkey.ply";
+  const uint32_t scale = argc > 2 ? (uint32_t)std::stoi(argv[2]) : 200;
+
+  try
+  {
+    for (const auto& fileName : { source, WriteScaled(source, scale) })
+    {
+      std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+      const double megabytes = (double)file.tellg() / 1e6;
+
+      std::vector<lpe::Vertex> legacyVertices, vertices, parallelVertices;
+      std::vector<uint32_t> legacyIndices, indices, parallelIndices;
+
+      const double legacy = Measure([&]() { LoadLegacy(fileName, legacyVertices, legacyIndices); });
+      const double serial = Measure([&]() { lpe::PlyFile(fileName).Read(vertices, indices); });
+      const double parallel = Measure([&]() { lpe::PlyFile(fileName).Read(parallelVertices, parallelIndices, lpe::ThreadPool::Shared()); });
+
+      const bool identical = Same(legacyVertices, vertices) && Same(vertices, parallelVertices) && legacyIndices == indices && indices == parallelIndices;
+
+      printf("%s (%.1f MB, %zu vertices)\n", fileName.c_str(), megabytes, vertices.size());
+      printf("  legacy   %8.1f MB/s\n", megabytes / legacy);
+      printf("  PlyFile  %8.1f MB/s\n", megabytes / serial);
+      printf("  parallel %8.1f MB/s (%u threads)\n", megabytes / parallel, lpe::ThreadPool::Shared().GetThreadCount());
+      printf("  output %s\n", identical ? "identical" : "DIFFERENT");
+
+      if (!identical)
+      {
+        return 1;
+      }
+    }
+
+    std::remove("PlyBenchmark.ply");
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}